@@ -39,7 +39,8 @@
 
 #include <exception>
 
-static std::string lastError_;
+// per thread, so that concurrent calls (e.g. gf_batchLayout) do not mix up errors
+static thread_local std::string lastError_;
 
 void gf_emitError(const char* str) {
     lastError_ = str;
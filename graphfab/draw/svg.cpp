@@ -0,0 +1,254 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/draw/svg.h"
+#include "graphfab/layout/arrowhead.h"
+
+#include <stdio.h>
+
+int gf_renderSVG(gf_layoutInfo* l, gf_writeCallback write, void* user) {
+  using namespace Graphfab;
+
+  try {
+    Network* net = (Network*)l->net;
+    if (!net)
+      SBNW_THROW(InternalCheckFailureException, "No network set", "gf_renderSVG");
+    Canvas* can = (Canvas*)l->canv;
+    if (!can)
+      SBNW_THROW(InternalCheckFailureException, "No canvas set", "gf_renderSVG");
+
+    OutputSink out(write, user);
+    SVGRenderer renderer(can->getBox());
+    renderer.write(out, net);
+    if (!out.flush())
+      SBNW_THROW(InternalCheckFailureException, "Write failed", "gf_renderSVG");
+
+    return 0;
+  } catch (const Exception& e) {
+    gf_setError( e.getReport().c_str() );
+    return -1;
+  }
+}
+
+int gf_renderSVGfd(gf_layoutInfo* l, int fd) {
+  return gf_renderSVG(l, Graphfab::OutputSink::writeFD, &fd);
+}
+
+int gf_renderSVGFile(gf_layoutInfo* l, const char* filename) {
+  FILE* f = filename ? fopen(filename, "w") : NULL;
+  if (!f) {
+    gf_setError( ("Could not open file " + ( filename ? std::string(filename) : std::string("") )).c_str() );
+    return -1;
+  }
+
+  int result = gf_renderSVG(l, Graphfab::OutputSink::writeFILE, f);
+
+  if (fclose(f) && !result) {
+    gf_setError("gf_renderSVGFile: failed to write file");
+    return -1;
+  }
+  return result;
+}
+
+namespace Graphfab {
+
+  static const char* svgCurveClass(RxnCurveType role) {
+    switch (role) {
+      case RXN_CURVE_SUBSTRATE: return "substrate";
+      case RXN_CURVE_PRODUCT:   return "product";
+      case RXN_CURVE_ACTIVATOR: return "activator";
+      case RXN_CURVE_INHIBITOR: return "inhibitor";
+      case RXN_CURVE_MODIFIER:  return "modifier";
+      default:
+        SBNW_THROW(InternalCheckFailureException, "Unknown curve role", "svgCurveClass");
+    }
+  }
+
+  static ArrowheadStyle svgArrowheadStyle(RxnCurveType role) {
+    switch (role) {
+      case RXN_CURVE_SUBSTRATE: return ArrowheadStyleControl<SubstrateArrowhead>::get();
+      case RXN_CURVE_PRODUCT:   return ArrowheadStyleControl<ProductArrowhead>::get();
+      case RXN_CURVE_ACTIVATOR: return ArrowheadStyleControl<ActivatorArrowhead>::get();
+      case RXN_CURVE_INHIBITOR: return ArrowheadStyleControl<InhibitorArrowhead>::get();
+      case RXN_CURVE_MODIFIER:  return ArrowheadStyleControl<ModifierArrowhead>::get();
+      default:
+        SBNW_THROW(InternalCheckFailureException, "Unknown curve role", "svgArrowheadStyle");
+    }
+  }
+
+  SVGRenderer::SVGRenderer(Box extents)
+    : extents_(extents) {}
+
+  void SVGRenderer::putCoord(OutputSink& out, Real x) const {
+    // six significant digits are well below a pixel; putReal's default %.15g would double the file size
+    out.putReal(x, 6);
+  }
+
+  void SVGRenderer::putPoint(OutputSink& out, const Point& p) const {
+    putCoord(out, p.x);
+    out.put(',');
+    putCoord(out, p.y);
+  }
+
+  void SVGRenderer::putRect(OutputSink& out, const char* cls, const Box& b, Real r) const {
+    out.put("<rect class=\"");
+    out.put(cls);
+    out.put("\" x=\"");
+    putCoord(out, b.getMin().x);
+    out.put("\" y=\"");
+    putCoord(out, b.getMin().y);
+    out.put("\" width=\"");
+    putCoord(out, b.width());
+    out.put("\" height=\"");
+    putCoord(out, b.height());
+    out.put("\" rx=\"");
+    putCoord(out, r);
+    out.put("\"/>\n");
+  }
+
+  void SVGRenderer::putCurve(OutputSink& out, RxnBezier* c) const {
+    out.put("<path class=\"");
+    out.put(svgCurveClass(c->getRole()));
+    out.put("\" d=\"M");
+    putPoint(out, c->getTransformedS());
+    out.put(" C");
+    putPoint(out, c->getTransformedC1());
+    out.put(' ');
+    putPoint(out, c->getTransformedC2());
+    out.put(' ');
+    putPoint(out, c->getTransformedE());
+    out.put("\"/>\n");
+  }
+
+  void SVGRenderer::putArrowhead(OutputSink& out, RxnBezier* c) const {
+    if (!c->hasArrowhead())
+      return;
+
+    Arrowhead* a = c->getArrowhead();
+    unsigned long n = a->getNumVerts();
+    if (n) {
+      bool filled = ArrowheadStyles::isFilled(svgArrowheadStyle(c->getRole()));
+      out.put(filled ? "<polygon class=\"filled " : "<polyline class=\"");
+      out.put(svgCurveClass(c->getRole()));
+      out.put("\" points=\"");
+      for (unsigned long k=0; k<n; ++k) {
+        if (k)
+          out.put(' ');
+        putPoint(out, a->getTransformedVert(k));
+      }
+      out.put("\"/>\n");
+    }
+    delete a;
+  }
+
+  void SVGRenderer::write(OutputSink& out, Network* net) {
+    out.put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    out.put("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+    putCoord(out, extents_.width());
+    out.put("\" height=\"");
+    putCoord(out, extents_.height());
+    out.put("\" viewBox=\"");
+    putCoord(out, extents_.getMin().x);
+    out.put(' ');
+    putCoord(out, extents_.getMin().y);
+    out.put(' ');
+    putCoord(out, extents_.width());
+    out.put(' ');
+    putCoord(out, extents_.height());
+    out.put("\">\n");
+
+    // same colors as the TikZ renderer
+    out.put(
+      "<defs>\n"
+      "<linearGradient id=\"node-fill\"><stop offset=\"0\" stop-color=\"#ff8080\"/><stop offset=\"1\" stop-color=\"#ffffff\"/></linearGradient>\n"
+      "<style>\n"
+      ".compartment{fill:#f5f5f5;stroke:#a0a0a0;stroke-width:2}\n"
+      ".node{fill:url(#node-fill);stroke:#cc8080;stroke-width:1}\n"
+      "path{fill:none;stroke-width:1.5}\n"
+      "polyline{fill:none;stroke-width:1.5}\n"
+      ".substrate,.product{stroke:#404040}\n"
+      ".modifier{stroke:#8080c0}\n"
+      ".activator{stroke:#40a040}\n"
+      ".inhibitor{stroke:#c04040}\n"
+      ".filled{stroke:none}\n"
+      ".filled.substrate,.filled.product{fill:#404040}\n"
+      ".filled.modifier{fill:#8080c0}\n"
+      ".filled.activator{fill:#40a040}\n"
+      ".filled.inhibitor{fill:#c04040}\n"
+      "text{font-family:sans-serif;font-size:10px;text-anchor:middle;dominant-baseline:central}\n"
+      "</style>\n"
+      "</defs>\n");
+
+    out.put("<g id=\"compartments\">\n");
+    for (Network::CompIt i=net->CompsBegin(); i!=net->CompsEnd(); ++i) {
+      Compartment* c = *i;
+      putRect(out, "compartment", c->getExtents(NetworkElement::COORD_SYSTEM_GLOBAL), 10.);
+    }
+    out.put("</g>\n");
+
+    out.put("<g id=\"reactions\">\n");
+    for (Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+      Reaction* r = *i;
+      //  rebuilds curves
+      r->getNumCurves();
+      for (Reaction::CurveIt ci=r->CurvesBegin(); ci!=r->CurvesEnd(); ++ci) {
+        putCurve(out, *ci);
+        putArrowhead(out, *ci);
+      }
+      if (out.failed())
+        return;
+    }
+    out.put("</g>\n");
+
+    out.put("<g id=\"nodes\">\n");
+    for (Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i) {
+      Node* n = *i;
+      Box b = n->getExtents(NetworkElement::COORD_SYSTEM_GLOBAL);
+      putRect(out, "node", b, 4.);
+
+      Point p = b.getCenter();
+      out.put("<text x=\"");
+      putCoord(out, p.x);
+      out.put("\" y=\"");
+      putCoord(out, p.y);
+      out.put("\">");
+      out.putEscaped(n->getName() != "" ? n->getName() : n->getId());
+      out.put("</text>\n");
+      if (out.failed())
+        return;
+    }
+    out.put("</g>\n");
+
+    out.put("</svg>\n");
+  }
+
+}
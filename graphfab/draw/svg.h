@@ -0,0 +1,115 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file svg.h
+ * @brief Render SVG images
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_DRAW_SVG_H_
+#define __SBNW_DRAW_SVG_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/box.h"
+#include "graphfab/layout/canvas.h"
+#include "graphfab/network/network.h"
+#include "graphfab/interface/layout.h"
+#include "graphfab/util/sink.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Render the model as an SVG image
+ *  @details Compartments, reaction curves, arrowheads and nodes are
+ *  written in a single pass over the network and passed to @a write in
+ *  chunks through a fixed-size buffer, so memory use does not grow with
+ *  the size of the network. The view box is the canvas.
+ *  @param[in] l The model/layout info
+ *  @param[in] write Receives the output
+ *  @param[in] user Passed to @a write
+ *  @return 0 on success; -1 on error or if @a write failed
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_renderSVG(gf_layoutInfo* l, gf_writeCallback write, void* user);
+
+/** @brief Render the model as an SVG image to a file descriptor
+ *  @details See @ref gf_renderSVG. The descriptor is not closed.
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_renderSVGfd(gf_layoutInfo* l, int fd);
+
+/** @brief Render the model as an SVG image to a file
+ *  @details See @ref gf_renderSVG.
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_renderSVGFile(gf_layoutInfo* l, const char* filename);
+
+#ifdef __cplusplus
+}//extern "C"
+#endif
+
+//-- C++ code --
+# ifdef __cplusplus
+
+namespace Graphfab {
+
+  /** @brief Writes a network as SVG to an @ref OutputSink
+   *  @details Nothing is buffered beyond the sink itself.
+   */
+  class _GraphfabExport SVGRenderer {
+    public:
+      /// @param[in] extents The region of the layout to show
+      SVGRenderer(Box extents);
+
+      /// Write the complete document; rebuilds the curves
+      void write(OutputSink& out, Network* net);
+
+    protected:
+      void putPoint(OutputSink& out, const Point& p) const;
+
+      void putCoord(OutputSink& out, Real x) const;
+
+      void putRect(OutputSink& out, const char* cls, const Box& b, Real r) const;
+
+      void putCurve(OutputSink& out, RxnBezier* c) const;
+
+      void putArrowhead(OutputSink& out, RxnBezier* c) const;
+
+      Box extents_;
+  };
+
+}
+
+# endif
+
+#endif
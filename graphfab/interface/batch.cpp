@@ -0,0 +1,277 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/batch.h"
+#include "graphfab/util/threadpool.h"
+
+#include "sbml/SBMLTypes.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace Graphfab {
+
+    /** @brief Limits the combined size of the inputs being processed
+     * @details One file is always admitted, so a file larger than the
+     * limit runs on its own rather than blocking forever.
+     */
+    class BatchBudget {
+        public:
+            explicit BatchBudget(uint64 limit)
+              : limit_(limit), used_(0), inflight_(0) {}
+
+            void acquire(uint64 bytes) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if(limit_)
+                    while(inflight_ && used_ + bytes > limit_)
+                        freed_.wait(lock);
+                used_ += bytes;
+                ++inflight_;
+            }
+
+            void release(uint64 bytes) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    used_ -= bytes;
+                    --inflight_;
+                }
+                freed_.notify_all();
+            }
+
+        protected:
+            uint64 limit_;
+            uint64 used_;
+            uint64 inflight_;
+            std::mutex mutex_;
+            std::condition_variable freed_;
+    };
+
+    class BatchTask : public RangeTask {
+        public:
+            BatchTask(const char* const* inputs, const char* const* outputs, fr_options opt,
+                      BatchBudget& budget, gf_batchResult* results)
+              : inputs_(inputs), outputs_(outputs), opt_(opt), budget_(budget), results_(results) {}
+
+            void run(uint64 begin, uint64 end) {
+                for(uint64 i=begin; i<end; ++i)
+                    runOne(inputs_[i], outputs_[i], results_[i]);
+            }
+
+        protected:
+            typedef std::chrono::steady_clock Clock;
+
+            static double since(Clock::time_point& t) {
+                Clock::time_point now = Clock::now();
+                double d = std::chrono::duration<double>(now - t).count();
+                t = now;
+                return d;
+            }
+
+            static uint64 fileSize(const char* path) {
+                FILE* f = fopen(path, "rb");
+                if(!f)
+                    return 0;
+                fseek(f, 0, SEEK_END);
+                long size = ftell(f);
+                fclose(f);
+                return size > 0 ? (uint64)size : 0;
+            }
+
+            /** @brief Seed for the layout of one file
+             * @details FNV-1a of the path, mixed with the caller's seed, so a
+             * file gets the same layout whichever thread runs it and
+             * whatever else is in the batch
+             */
+            static uint64 fileSeed(uint64 seed, const char* path) {
+                uint64 h = 14695981039346656037ULL ^ seed;
+                for(const char* c=path; *c; ++c) {
+                    h ^= (unsigned char)*c;
+                    h *= 1099511628211ULL;
+                }
+                // zero would mean "draw from rand()"
+                return h ? h : 1;
+            }
+
+            static void fail(gf_batchResult& r, gf_batchStage stage, const char* msg) {
+                r.status = -1;
+                r.failed_stage = stage;
+                strncpy(r.error, msg && *msg ? msg : "Unknown error", sizeof(r.error)-1);
+                r.error[sizeof(r.error)-1] = '\0';
+            }
+
+            /// Fail with the library's last error on this thread
+            static void failWithLastError(gf_batchResult& r, gf_batchStage stage, const char* fallback) {
+                char* e = gf_getLastError();
+                fail(r, stage, e && *e ? e : fallback);
+                gf_free(e);
+            }
+
+            void runOne(const char* input, const char* output, gf_batchResult& r) {
+                memset(&r, 0, sizeof(r));
+                r.bytes = fileSize(input);
+
+                budget_.acquire(r.bytes);
+
+                gf_SBMLModel* mod = NULL;
+                gf_layoutInfo* l = NULL;
+                gf_batchStage stage = GF_BATCH_STAGE_LOAD;
+                Clock::time_point t = Clock::now();
+                try {
+                    gf_clearError();
+                    mod = gf_loadSBMLfile(input);
+                    r.stage_time[stage] = since(t);
+                    if(!mod || !mod->pdoc) {
+                        failWithLastError(r, stage, "Failed to load file");
+                    } else if(!((SBMLDocument*)mod->pdoc)->getModel()) {
+                        // gf_processLayout asserts on this
+                        fail(r, stage, "No model in file");
+                    } else {
+                        stage = GF_BATCH_STAGE_PROCESS;
+                        l = gf_processLayout(mod);
+                        r.stage_time[stage] = since(t);
+                        if(!l) {
+                            failWithLastError(r, stage, "Failed to process layout");
+                        } else {
+                            stage = GF_BATCH_STAGE_LAYOUT;
+                            fr_options opt(opt_);
+                            opt.random_seed = fileSeed(opt_.random_seed, input);
+                            gf_doLayoutAlgorithm(opt, l);
+                            r.stage_time[stage] = since(t);
+
+                            stage = GF_BATCH_STAGE_WRITE;
+                            if(gf_writeSBMLwithLayout(output, mod, l))
+                                failWithLastError(r, stage, "Failed to write file");
+                            r.stage_time[stage] = since(t);
+                        }
+                    }
+                } catch(const Exception& e) {
+                    r.stage_time[stage] += since(t);
+                    fail(r, stage, e.getReport().c_str());
+                } catch(const std::exception& e) {
+                    r.stage_time[stage] += since(t);
+                    fail(r, stage, e.what());
+                } catch(...) {
+                    r.stage_time[stage] += since(t);
+                    fail(r, stage, "Unknown exception");
+                }
+
+                try {
+                    if(l)
+                        gf_freeLayoutInfoHierarch(l);
+                    if(mod)
+                        gf_freeSBMLModel(mod);
+                } catch(...) {
+                    if(!r.status)
+                        fail(r, stage, "Exception while freeing model");
+                }
+
+                budget_.release(r.bytes);
+            }
+
+            const char* const* inputs_;
+            const char* const* outputs_;
+            fr_options opt_;
+            BatchBudget& budget_;
+            gf_batchResult* results_;
+    };
+
+}
+
+using namespace Graphfab;
+
+void gf_getBatchOptDefaults(gf_batchOptions* opt) {
+    opt->threads = 0;
+    opt->max_inflight_bytes = 0;
+}
+
+const char* gf_batchStageName(gf_batchStage stage) {
+    switch(stage) {
+        case GF_BATCH_STAGE_LOAD:
+            return "load";
+        case GF_BATCH_STAGE_PROCESS:
+            return "process";
+        case GF_BATCH_STAGE_LAYOUT:
+            return "layout";
+        case GF_BATCH_STAGE_WRITE:
+            return "write";
+        default:
+            return "unknown";
+    }
+}
+
+uint64_t gf_batchLayout(const char* const* inputs, const char* const* outputs, uint64_t n,
+                        fr_options opt, gf_batchOptions bopt,
+                        gf_batchResult* results, gf_batchStats* stats) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<gf_batchResult> local;
+    if(!results) {
+        local.resize(n);
+        results = n ? &local.front() : NULL;
+    }
+
+    ThreadPool pool(bopt.threads);
+    // parallelism is across files
+    if(pool.getNumThreads() > 1)
+        opt.parallel = 0;
+
+    BatchBudget budget(bopt.max_inflight_bytes);
+    BatchTask task(inputs, outputs, opt, budget, results);
+    // one file at a time: idle threads pick up the next file
+    pool.parallelFor(n, 1, task);
+
+    uint64_t failed = 0;
+    for(uint64_t i=0; i<n; ++i)
+        if(results[i].status)
+            ++failed;
+
+    if(stats) {
+        memset(stats, 0, sizeof(*stats));
+        stats->files = n;
+        stats->failed = failed;
+        stats->threads = pool.getNumThreads();
+        for(uint64_t i=0; i<n; ++i) {
+            stats->bytes += results[i].bytes;
+            for(int s=0; s<GF_BATCH_NUM_STAGES; ++s)
+                stats->stage_time[s] += results[i].stage_time[s];
+        }
+        stats->wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    return failed;
+}
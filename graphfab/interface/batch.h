@@ -0,0 +1,154 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file batch.h
+ * @brief Lay out many SBML files at once
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_INTERFACE_BATCH_H_
+#define __SBNW_INTERFACE_BATCH_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/layout.h"
+#include "graphfab/layout/fr.h"
+
+#include <stdint.h>
+
+//-- C methods --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Pipeline stages timed by @ref gf_batchLayout
+typedef enum {
+    GF_BATCH_STAGE_LOAD,
+    GF_BATCH_STAGE_PROCESS,
+    GF_BATCH_STAGE_LAYOUT,
+    GF_BATCH_STAGE_WRITE,
+    GF_BATCH_NUM_STAGES
+} gf_batchStage;
+
+/**
+ *  @brief Options for @ref gf_batchLayout
+ *  @sa gf_getBatchOptDefaults
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// Number of files processed at once (0 = one per hardware thread)
+    uint64_t threads;
+    /**
+     * @brief Upper bound on the combined size in bytes of the input files
+     * being processed at once (0 = no limit)
+     * @details Memory use is dominated by the SBML documents, which grow
+     * with the file size. A file larger than the bound still runs, but
+     * on its own.
+     */
+    uint64_t max_inflight_bytes;
+} gf_batchOptions;
+
+/**
+ *  @brief Outcome for one file of a batch
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// 0 on success
+    int status;
+    /// Stage which failed (if status is nonzero)
+    gf_batchStage failed_stage;
+    /// Error message (empty on success)
+    char error[256];
+    /// Input size in bytes
+    uint64_t bytes;
+    /// Wall time spent in each stage, in seconds
+    double stage_time[GF_BATCH_NUM_STAGES];
+} gf_batchResult;
+
+/**
+ *  @brief Totals for a whole batch
+ *  \ingroup C_API
+ */
+typedef struct {
+    uint64_t files;
+    uint64_t failed;
+    /// Total input size in bytes
+    uint64_t bytes;
+    /// Number of threads used
+    uint64_t threads;
+    /// Wall time for the batch, in seconds
+    double wall_time;
+    /// Sum over files of the time spent in each stage, in seconds
+    double stage_time[GF_BATCH_NUM_STAGES];
+} gf_batchStats;
+
+/** @brief Fill @a opt with the defaults: one thread per core, no memory bound
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_getBatchOptDefaults(gf_batchOptions* opt);
+
+/** @brief Name of a pipeline stage (static string)
+ *  \ingroup C_API
+ */
+_GraphfabExport const char* gf_batchStageName(gf_batchStage stage);
+
+/**
+ *  @brief Lay out a list of SBML files
+ *  @details Each input is run through @ref gf_loadSBMLfile,
+ *  @ref gf_processLayout, @ref gf_doLayoutAlgorithm and
+ *  @ref gf_writeSBMLwithLayout, and freed before the thread moves on to
+ *  the next file. Files are handed out one at a time to whichever
+ *  thread is free, so slow models do not hold up the rest. A failure
+ *  in one file is recorded in its result and does not affect the others.
+ *  When more than one thread is used, each layout runs single-threaded.
+ *  Each layout is seeded from @ref fr_options::random_seed and the input
+ *  path, so the output does not depend on the number of threads or on
+ *  the order in which files finish.
+ *  @param[in] inputs Input SBML files
+ *  @param[in] outputs Output file for each input
+ *  @param[in] n Number of files
+ *  @param[in] opt Layout options applied to every file
+ *  @param[in] bopt Batch options
+ *  @param[out] results Caller-allocated array of @a n results (may be NULL)
+ *  @param[out] stats Totals for the batch (may be NULL)
+ *  @return The number of files which failed
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_batchLayout(const char* const* inputs, const char* const* outputs, uint64_t n,
+                                        fr_options opt, gf_batchOptions bopt,
+                                        gf_batchResult* results, gf_batchStats* stats);
+
+#ifdef __cplusplus
+}//extern "C"
+#endif
+
+#endif
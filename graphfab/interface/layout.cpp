@@ -46,6 +46,10 @@
 
 #include <exception>
 #include <typeinfo>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
 
 #include <stdlib.h> // free SBML strings
 
@@ -271,28 +275,49 @@ int gf_aliasNode(gf_layoutInfo* l, const char* id) {
     if(!n)
         return 1;
     n->setAlias(true);
-    for(Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+    Network::AttachedRxnList rxns = net->getConnectedReactions(n);
+    for(Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
         Graphfab::Reaction* r = *i;
-        if(r->hasSpecies(n)) {
-            Node* w = new Node(*n);
-            w->setGlyph(w->getGlyph() + "_" + r->getId());
-            w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
-            net->addNode(w);
-            r->substituteSpecies(n, w);
-        }
+        Node* w = net->newNode(*n);
+        w->setGlyph(w->getGlyph() + "_" + r->getId());
+        w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
+        net->addNode(w);
+        r->substituteSpecies(n, w);
     }
     return 0;
 }
 
+// number of nodes in the subgraph containing x
+static size_t countSubgraphNodes(Network* net, Node* x) {
+    std::set<Node*> found;
+    std::set<Graphfab::Reaction*> visited;
+    std::vector<Node*> stack;
+
+    found.insert(x);
+    stack.push_back(x);
+    while(!stack.empty()) {
+        Node* u = stack.back();
+        stack.pop_back();
+        Network::AttachedRxnList rxns = net->getConnectedReactions(u);
+        for(Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
+            if(!visited.insert(*i).second)
+                continue;
+            for(Graphfab::Reaction::NodeIt j=(*i)->NodesBegin(); j!=(*i)->NodesEnd(); ++j)
+                if(found.insert(j->first).second)
+                    stack.push_back(j->first);
+        }
+    }
+
+    return found.size();
+}
+
 void gf_aliasNodebyDegree(gf_layoutInfo* l, int minDegree) {
     Network* net = (Network*)l->net;
     AN(net, "No network");
 
-    int a, b, nodecount1, nodecount2, size = net->getTotalNumNodes(), i = 0, aliasCount = 0;
+    int nodecount1, nodecount2, size = net->getTotalNumNodes(), i = 0, aliasCount = 0;
     char aliasCountString[33];
     sprintf(aliasCountString, "%d", aliasCount);
-    std::vector<Node *> foundNodes;
-    std::vector<Graphfab::Reaction *> Rxns;
 
     //Iterator does not work because nodes are added to the list, had to use while loop instead
     //for(Network::NodeIt i = net->NodesBegin(); i < net->NodesEnd(); ++i) {
@@ -302,106 +327,42 @@ void gf_aliasNodebyDegree(gf_layoutInfo* l, int minDegree) {
         //If the node is the required minimum degree or greater and is not an alias
         if(n->degree() >= minDegree && !n->isCentroidSet() && !n->isAlias()) {
 
-            for(Network::RxnIt c=net->RxnsBegin(); c!=net->RxnsEnd(); ++c) {
+            Network::AttachedRxnList rxns = net->getConnectedReactions(n);
+            for(Network::AttachedRxnList::iterator c=rxns.begin(); c!=rxns.end(); ++c) {
                 Graphfab::Reaction* r = *c;
 
-                if(r->hasSpecies(n)) {
-                    if(n->degree() > 1) {
-
-                        //Create a temp copy of all reactions
-                        for(Network::RxnIt d=net->RxnsBegin(); d!=net->RxnsEnd(); ++d) {
-                            Graphfab::Reaction* react = *d;
-                            Rxns.push_back(react);
-                        }
-
-                        foundNodes.push_back(n);
-
-                        //Find all nodes that are in the subgraph with node n
-                        a = 0;
-                        while(a < foundNodes.size()) {
-                            b = 0;
-                            while(b < Rxns.size()) {
-                                if(Rxns[b]->hasSpecies(foundNodes[a])) {
-                                    for(Graphfab::Reaction::NodeIt j=Rxns[b]->NodesBegin(); j!=Rxns[b]->NodesEnd(); ++j) {
-                                        Graphfab::Node* node = j->first;
-                                        for(int m = 0; m < foundNodes.size(); ++m) {
-                                            if(node == foundNodes[m]) break;
-                                            else if(m == foundNodes.size() - 1) foundNodes.push_back(node);
-                                        }
-                                    }
-                                    Rxns.erase(Rxns.begin() + b);
-                                }
-                                else {
-                                    b++;
-                                }
-                            }
-                            a++;
-                        }
-
-                        nodecount1 = foundNodes.size();
-
-                        //Create the alias node
-                        Node* w = new Node(*n);
-                        w->setGlyph(w->getGlyph() + "_" + r->getId() + "_alias_" + aliasCountString);
-                        w->set_degree(1);
-                        w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
-                        w->setAlias(true);
-                        //Substitute the alias into the current reaction, but don't add to the network
-                        r->substituteSpecies(n, w);
-                        n->set_degree(n->degree() - 1);
-
-                        Rxns.clear();
-                        foundNodes.clear();
-
-                        //Create a temp copy of all reactions
-                        for(Network::RxnIt d=net->RxnsBegin(); d!=net->RxnsEnd(); ++d) {
-                            Graphfab::Reaction* react = *d;
-                            Rxns.push_back(react);
-                        }
-
-                        foundNodes.push_back(w);
-
-                        //Find all nodes that are in the subgraph with the alias node
-                        a = 0;
-                        while(a < foundNodes.size()) {
-                            b = 0;
-                            while(b < Rxns.size()) {
-                                if(Rxns[b]->hasSpecies(foundNodes[a])) {
-                                    for(Graphfab::Reaction::NodeIt j=Rxns[b]->NodesBegin(); j!=Rxns[b]->NodesEnd(); ++j) {
-                                        Graphfab::Node* node = j->first;
-                                        for(int m = 0; m < foundNodes.size(); ++m) {
-                                            if(node == foundNodes[m]) break;
-                                            else if(m == foundNodes.size() - 1) foundNodes.push_back(node);
-                                        }
-                                    }
-                                    Rxns.erase(Rxns.begin() + b);
-                                }
-                                else {
-                                    b++;
-                                }
-                            }
-                            a++;
-                        }
-
-                        nodecount2 = foundNodes.size();
-
-
-                        if(nodecount1 > nodecount2) {
-
-                            //If we lost a node(s), reset the connection to the original
-
-                            r->substituteSpecies(w, n);
-                            n->set_degree(n->degree() + 1);
-                            delete(w);
-
-                        } else {
-                            //The node counts are equal. The alias can be kept
-                            net->addNode(w);
-                            aliasCount++;
-                            sprintf(aliasCountString, "%d", aliasCount);
-                        }
-                    }
+                if(n->degree() > 1) {
+
+                    //Find all nodes that are in the subgraph with node n
+                    nodecount1 = countSubgraphNodes(net, n);
+
+                    //Create the alias node
+                    Node* w = net->newNode(*n);
+                    w->setGlyph(w->getGlyph() + "_" + r->getId() + "_alias_" + aliasCountString);
+                    w->set_degree(1);
+                    w->setCentroid(new2ndPos(r->getCentroid(), w->getCentroid(), 0., -25., false));
+                    w->setAlias(true);
+                    //Substitute the alias into the current reaction, but don't add to the network
+                    r->substituteSpecies(n, w);
+                    n->set_degree(n->degree() - 1);
 
+                    //Find all nodes that are in the subgraph with the alias node
+                    nodecount2 = countSubgraphNodes(net, w);
+
+                    if(nodecount1 > nodecount2) {
+
+                        //If we lost a node(s), reset the connection to the original
+
+                        r->substituteSpecies(w, n);
+                        n->set_degree(n->degree() + 1);
+                        Network::releaseElt(w);
+
+                    } else {
+                        //The node counts are equal. The alias can be kept
+                        net->addNode(w);
+                        aliasCount++;
+                        sprintf(aliasCountString, "%d", aliasCount);
+                    }
                 }
             }
         }
@@ -1092,6 +1053,12 @@ void gf_nw_rebuildCurves(gf_network* n) {
     net->rebuildCurves();
 }
 
+uint64_t gf_nw_recalcDirtyCurves(gf_network* n) {
+    Network* net = CastToNetwork(n->n);
+    AN(net, "No network");
+    return net->recalcDirtyCurves();
+}
+
 void gf_nw_recenterJunctions(gf_network* n) {
     Network* net = CastToNetwork(n->n);
     AN(net, "No network");
@@ -1105,7 +1072,7 @@ gf_compartment gf_nw_newCompartment(gf_network* nw, const char* id, const char*
     AN(net, "No network");
 
     std::cout << "gf_nw_newCompartment started\n";
-    Graphfab::Compartment* c = new Graphfab::Compartment();
+    Graphfab::Compartment* c = net->newCompartment();
 
     std::cout << "gf_nw_newCompartment setting id\n";
     c->setName(name);
@@ -1140,7 +1107,7 @@ gf_node gf_nw_newNode(gf_network* nw, const char* id, const char* name, gf_compa
     AN(net, "No network");
 
 //     std::cout << "gf_nw_newNode started\n";
-    Node* n = new Node();
+    Node* n = net->newNode();
 
 //     std::cout << "gf_nw_newNode setting id\n";
     n->setName(name);
@@ -1184,7 +1151,7 @@ gf_node gf_nw_aliasOf(gf_network* nw, gf_node* srcnode) {
     AN(net, "No network");
 
 //     std::cout << "gf_nw_newNode started\n";
-    Node* n = new Node();
+    Node* n = net->newNode();
 
 //     std::cout << "gf_nw_newNode setting id\n";
     n->setName(src->getName());
@@ -1357,7 +1324,7 @@ void gf_releaseNode(const gf_node* n) {
     Node* node = CastToNode(n->n);
     AN(node, "No node");
 
-    delete node;
+    Network::releaseElt(node);
 }
 
 CPoint Point2CPoint(const Graphfab::Point& p) {
@@ -1601,7 +1568,7 @@ void gf_releaseRxn(const gf_reaction* r) {
     AN(rxn, "No rxn");
     AT(rxn->doByteCheck(), "Type verification failed");
 
-    delete rxn;
+    Network::releaseElt(rxn);
 }
 
 gf_reaction gf_nw_newReaction(gf_network* nw, const char* id, const char* name) {
@@ -1611,7 +1578,7 @@ gf_reaction gf_nw_newReaction(gf_network* nw, const char* id, const char* name)
     AN(net, "No network");
 
     std::cout << "gf_nw_newReaction started\n";
-    Graphfab::Reaction* r = new Graphfab::Reaction();
+    Graphfab::Reaction* r = net->newReaction();
 
     std::cout << "gf_nw_newReaction setting id\n";
     r->setName(name);
@@ -1893,7 +1860,7 @@ void gf_releaseCompartment(const gf_compartment* c) {
       return;
     }
 
-    delete comp;
+    Network::releaseElt(comp);
 }
 
 char* gf_compartment_getID(gf_compartment* c) {
@@ -2084,6 +2051,18 @@ CPoint gf_tf_apply_to_point(gf_transform* tf, CPoint p) {
     return Point2CPoint(r);
 }
 
+void gf_tf_apply_to_points(gf_transform* tf, const CPoint* in, CPoint* out, uint64_t n) {
+    Graphfab::Affine2d* t = (Graphfab::Affine2d*)tf->tf;
+    AN(t, "No transform");
+    std::vector<Graphfab::Point> p(n);
+    for(uint64_t i=0; i<n; ++i)
+        p[i] = CPoint2Point(in[i]);
+    if(n)
+        t->transformPoints(&p.front(), &p.front(), n);
+    for(uint64_t i=0; i<n; ++i)
+        out[i] = Point2CPoint(p[i]);
+}
+
 gf_point gf_tf_getScale(gf_transform* tf) {
   Graphfab::Affine2d* t = (Graphfab::Affine2d*)tf->tf;
   AN(t, "No transform");
@@ -2209,6 +2188,341 @@ const char* gf_getSBMLwithLayoutStr(gf_SBMLModel* m, gf_layoutInfo* l) {
     return gf_strclone(l->cont);
 }
 
+// -- Layout patching --
+
+static ::SpeciesReferenceRole_t GraphfabRole2SBMLRole(RxnRoleType role) {
+    switch(role) {
+        case RXN_ROLE_SUBSTRATE:
+            return SPECIES_ROLE_SUBSTRATE;
+        case RXN_ROLE_PRODUCT:
+            return SPECIES_ROLE_PRODUCT;
+        case RXN_ROLE_SIDESUBSTRATE:
+            return SPECIES_ROLE_SIDESUBSTRATE;
+        case RXN_ROLE_SIDEPRODUCT:
+            return SPECIES_ROLE_SIDEPRODUCT;
+        case RXN_ROLE_MODIFIER:
+            return SPECIES_ROLE_MODIFIER;
+        case RXN_ROLE_ACTIVATOR:
+            return SPECIES_ROLE_ACTIVATOR;
+        case RXN_ROLE_INHIBITOR:
+            return SPECIES_ROLE_INHIBITOR;
+        default:
+            AN(0, "Unrecognized role");
+            return SPECIES_ROLE_UNDEFINED;
+    }
+}
+
+static void setGlyphBox(GraphicalObject* g, Real x, Real y, Real width, Real height) {
+    BoundingBox bb;
+    bb.setX(sround(x));
+    bb.setY(sround(y));
+    bb.setWidth(sround(width));
+    bb.setHeight(sround(height));
+    g->setBoundingBox(&bb);
+}
+
+typedef std::multimap<std::string, TextGlyph*> TextGlyphMap;
+
+// move a glyph to the given box, dragging its labels along
+static void moveGlyph(GraphicalObject* g, const Graphfab::Box& b, TextGlyphMap& text_glyphs) {
+    const BoundingBox* old = g->getBoundingBox();
+    Real dx = sround(b.getMin().x) - old->x();
+    Real dy = sround(b.getMin().y) - old->y();
+    setGlyphBox(g, b.getMin().x, b.getMin().y, b.width(), b.height());
+
+    std::pair<TextGlyphMap::iterator, TextGlyphMap::iterator> r = text_glyphs.equal_range(g->getId());
+    for(TextGlyphMap::iterator t=r.first; t!=r.second; ++t) {
+        BoundingBox* tb = t->second->getBoundingBox();
+        tb->setX(tb->x() + dx);
+        tb->setY(tb->y() + dy);
+    }
+}
+
+static void setGlyphCurve(SpeciesReferenceGlyph* srg, const RxnBezier* c) {
+    ::Curve curv;
+    CubicBezier* cb = curv.createCubicBezier();
+
+    ::Point p;
+
+    p.setX(c->s.x);
+    p.setY(c->s.y);
+    cb->setStart(&p);
+    p.setX(c->e.x);
+    p.setY(c->e.y);
+    cb->setEnd(&p);
+
+    p.setX(c->c1.x);
+    p.setY(c->c1.y);
+    cb->setBasePoint1(&p);
+    p.setX(c->c2.x);
+    p.setY(c->c2.y);
+    cb->setBasePoint2(&p);
+
+    // replaces any existing curve (including multi-segment ones)
+    srg->setCurve(&curv);
+}
+
+// id of the species reference in the model that a new SRG should point to, if any
+static std::string findSpeciesRefId(const ::Reaction* reaction, const std::string& species, RxnRoleType role) {
+    if(role == RXN_ROLE_MODIFIER || role == RXN_ROLE_ACTIVATOR || role == RXN_ROLE_INHIBITOR) {
+        for(unsigned int k=0; k<reaction->getNumModifiers(); ++k)
+            if(reaction->getModifier(k)->getSpecies() == species)
+                return reaction->getModifier(k)->getId();
+    } else if(role == RXN_ROLE_SUBSTRATE || role == RXN_ROLE_SIDESUBSTRATE) {
+        for(unsigned int k=0; k<reaction->getNumReactants(); ++k)
+            if(reaction->getReactant(k)->getSpecies() == species)
+                return reaction->getReactant(k)->getId();
+    } else {
+        for(unsigned int k=0; k<reaction->getNumProducts(); ++k)
+            if(reaction->getProduct(k)->getSpecies() == species)
+                return reaction->getProduct(k)->getId();
+    }
+    return "";
+}
+
+/* Patch the layout of an existing document. Only bounding boxes, curves and
+ * layout dimensions of existing glyphs are modified; glyphs are created for
+ * network elements which have none (provided the model element exists), and
+ * nothing is removed.
+ */
+static void patchSBMLLayout(SBMLDocument* doc, Network* net, Canvas* can) {
+    // enable the layout package if it is not already
+    if (!doc->isPkgEnabled("layout")) {
+        if (doc->getLevel() == 2) {
+            doc->enablePackage(LayoutExtension::getXmlnsL2(), "layout",  true);
+        } else if (doc->getLevel() == 3) {
+            doc->enablePackage(LayoutExtension::getXmlnsL3V1V1(), "layout",  true);
+            doc->setPkgRequired("layout", false);
+        }
+    }
+    AT(doc->isPkgEnabled("layout"), "Layout package not enabled");
+
+    Model* mod = doc->getModel();
+    AN(mod, "No model");
+
+    SBasePlugin* layoutBase = mod->getPlugin("layout");
+    AN(layoutBase, "No plugin named \"layout\"");
+    LayoutModelPlugin* layoutPlugin = dynamic_cast<LayoutModelPlugin*>(layoutBase);
+    AN(layoutPlugin, "Unable to get layout information");
+
+    // patch the same layout gf_processLayout reads from
+    Layout* lay = layoutPlugin->getLayout(0);
+    if(!lay) {
+        lay = layoutPlugin->createLayout();
+        lay->setId("Graphfab_Layout");
+    }
+
+    Dimensions dims;
+    dims.setWidth(can ? can->getWidth() : 1024.);
+    dims.setHeight(can ? can->getHeight() : 1024.);
+    lay->setDimensions(&dims);
+
+    net->rebuildCurves();
+
+    // index the existing glyphs once; the Layout getters are linear searches
+    std::map<std::string, CompartmentGlyph*> comp_glyphs;
+    for(unsigned int k=0; k<lay->getNumCompartmentGlyphs(); ++k)
+        comp_glyphs[lay->getCompartmentGlyph(k)->getId()] = lay->getCompartmentGlyph(k);
+    std::map<std::string, SpeciesGlyph*> spec_glyphs;
+    for(unsigned int k=0; k<lay->getNumSpeciesGlyphs(); ++k)
+        spec_glyphs[lay->getSpeciesGlyph(k)->getId()] = lay->getSpeciesGlyph(k);
+
+    // text glyphs, by the glyph they label
+    TextGlyphMap text_glyphs;
+    for(unsigned int k=0; k<lay->getNumTextGlyphs(); ++k) {
+        TextGlyph* tg = lay->getTextGlyph(k);
+        if(tg->isSetGraphicalObjectId())
+            text_glyphs.insert(std::make_pair(tg->getGraphicalObjectId(), tg));
+    }
+
+    // compartments
+    for(Network::ConstCompIt i=net->CompsBegin(); i!=net->CompsEnd(); ++i) {
+        const Graphfab::Compartment* c = *i;
+
+        if(comp_glyphs.count(c->getGlyph())) {
+            moveGlyph(comp_glyphs[c->getGlyph()], c->getExtents(), text_glyphs);
+            continue;
+        }
+        // no glyph: create one if the compartment is in the model
+        if(!mod->getCompartment(c->getId()))
+            continue;
+        CompartmentGlyph* cg = lay->createCompartmentGlyph();
+        cg->setId(c->getGlyph() != "" ? c->getGlyph() : c->getId() + "_Glyph");
+        cg->setCompartmentId(c->getId());
+        setGlyphBox(cg, c->getMinX(), c->getMinY(), c->getWidth(), c->getHeight());
+    }
+
+    // species
+    uint64 calias=0;
+    for(Network::NodeIt i=net->NodesBegin(); i!=net->NodesEnd(); ++i) {
+        Node* n = *i;
+        AN(n, "Empty node");
+
+        if(spec_glyphs.count(n->getGlyph())) {
+            moveGlyph(spec_glyphs[n->getGlyph()], n->getExtents(), text_glyphs);
+            continue;
+        }
+        if(!mod->getSpecies(n->getId()))
+            continue;
+
+        // new glyph: pick an id that is not already taken
+        if(n->getGlyph() == "") {
+            std::string gly = n->getId() + "_Glyph";
+            while(n->isAlias() || spec_glyphs.count(gly)) {
+                std::stringstream ss;
+                ss << n->getId() << "_Alias" << ++calias << "_Glyph";
+                gly = ss.str();
+                if(!spec_glyphs.count(gly))
+                    break;
+            }
+            n->setGlyph(gly);
+        }
+
+        SpeciesGlyph* sg = lay->createSpeciesGlyph();
+        sg->setId(n->getGlyph());
+        spec_glyphs[n->getGlyph()] = sg;
+        sg->setSpeciesId(n->getId());
+        setGlyphBox(sg, n->getMinX(), n->getMinY(), n->getWidth(), n->getHeight());
+
+        TextGlyph* tg = lay->createTextGlyph();
+        tg->setId("t" + n->getGlyph());
+        tg->setGraphicalObjectId(n->getGlyph());
+        tg->setText(n->getName() != "" ? n->getName() : n->getId());
+        setGlyphBox(tg, n->getMinX(), n->getMinY(), n->getWidth(), n->getHeight());
+    }
+
+    // reaction glyphs, by reaction id
+    std::map<std::string, ReactionGlyph*> rxn_glyphs;
+    for(unsigned int k=0; k<lay->getNumReactionGlyphs(); ++k) {
+        ReactionGlyph* rg = lay->getReactionGlyph(k);
+        if(rg->isSetReactionId() && !rxn_glyphs.count(rg->getReactionId()))
+            rxn_glyphs[rg->getReactionId()] = rg;
+    }
+
+    for(Network::ConstRxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+        const Graphfab::Reaction* r = *i;
+        AN(r, "Empty reaction");
+
+        const ::Reaction* reaction = mod->getReaction(r->getId());
+        if(!reaction)
+            continue;
+
+        ReactionGlyph* rg = NULL;
+        if(rxn_glyphs.count(r->getId()))
+            rg = rxn_glyphs[r->getId()];
+        else {
+            rg = lay->createReactionGlyph();
+            rg->setId(r->getId() + "_Glyph");
+            rg->setReactionId(r->getId());
+        }
+
+        // center the existing box (if any) on the centroid
+        {
+            const BoundingBox* old = rg->getBoundingBox();
+            Real w = old->width(), h = old->height();
+            setGlyphBox(rg, r->getCentroid().x - w*0.5, r->getCentroid().y - h*0.5, w, h);
+        }
+
+        std::vector<bool> used(rg->getNumSpeciesReferenceGlyphs(), false);
+        std::set<std::string> srg_ids;
+        for(unsigned int k=0; k<rg->getNumSpeciesReferenceGlyphs(); ++k)
+            srg_ids.insert(rg->getSpeciesReferenceGlyph(k)->getId());
+
+        uint64 sref=0;
+        Graphfab::Reaction::ConstNodeIt in=r->NodesBegin();
+        Graphfab::Reaction::ConstCurveIt ic=r->CurvesBegin();
+        for(;in != r->NodesEnd() && ic != r->CurvesEnd(); ++in, ++ic) {
+            const Node* n = in->first;
+            AN(n, "Empty species reference");
+            const RxnBezier* c = *ic;
+            AN(c, "Empty curve reference");
+
+            ::SpeciesReferenceRole_t role = GraphfabRole2SBMLRole(in->second);
+
+            // match on species glyph and role, then on species glyph alone
+            SpeciesReferenceGlyph* srg = NULL;
+            for(int pass=0; pass<2 && !srg; ++pass)
+                for(unsigned int k=0; k<rg->getNumSpeciesReferenceGlyphs(); ++k) {
+                    SpeciesReferenceGlyph* s = rg->getSpeciesReferenceGlyph(k);
+                    if(!used.at(k) && s->getSpeciesGlyphId() == n->getGlyph() && (pass || s->getRole() == role)) {
+                        used.at(k) = true;
+                        srg = s;
+                        break;
+                    }
+                }
+
+            if(!srg) {
+                if(!spec_glyphs.count(n->getGlyph()))
+                    continue;
+                srg = rg->createSpeciesReferenceGlyph();
+                std::string id;
+                do {
+                    std::stringstream ss;
+                    ss << r->getId() << "_SpeciesRef" << ++sref;
+                    id = ss.str();
+                } while(srg_ids.count(id));
+                srg_ids.insert(id);
+                srg->setId(id);
+                std::string ref = findSpeciesRefId(reaction, n->getId(), in->second);
+                if(ref != "")
+                    srg->setSpeciesReferenceId(ref);
+                srg->setSpeciesGlyphId(n->getGlyph());
+                srg->setRole(role);
+            }
+
+            setGlyphCurve(srg, c);
+        }
+    }
+}
+
+int gf_patchSBMLLayout(gf_SBMLModel* m, gf_layoutInfo* l) {
+    AN(m, "No model");
+    AN(l, "No layout info");
+    SBMLDocument* doc = (SBMLDocument*)m->pdoc;
+    Network* net = (Network*)l->net;
+    if(!doc || !doc->getModel()) {
+        gf_setError("gf_patchSBMLLayout: no SBML model");
+        return -1;
+    }
+    if(!net) {
+        gf_setError("gf_patchSBMLLayout: no network");
+        return -1;
+    }
+    AT(net->doByteCheck(), "Network has wrong type");
+
+    try {
+        patchSBMLLayout(doc, net, (Canvas*)l->canv);
+    } catch(const Exception& e) {
+        gf_setError(e.getReport().c_str());
+        return -1;
+    }
+    return 0;
+}
+
+int gf_writeSBMLLayoutPatch(const char* filename, gf_SBMLModel* m, gf_layoutInfo* l) {
+    if(gf_patchSBMLLayout(m, l))
+        return -1;
+    SBMLWriter writer;
+    writer.setProgramName("Graphfab");
+    if(writer.writeSBML((SBMLDocument*)m->pdoc, filename))
+        return 0;
+    else
+        return -1;
+}
+
+const char* gf_getSBMLLayoutPatchStr(gf_SBMLModel* m, gf_layoutInfo* l) {
+    if(gf_patchSBMLLayout(m, l))
+        return NULL;
+    SBMLWriter writer;
+    writer.setProgramName("Graphfab");
+
+    if(l->cont)
+        free(l->cont);
+    l->cont = writer.writeSBMLToString((SBMLDocument*)m->pdoc);
+
+    return gf_strclone(l->cont);
+}
+
 void gf_randomizeLayout(gf_layoutInfo* m) {
     Network* net = (Network*)m->net;
     AN(net, "No network");
@@ -2269,6 +2583,22 @@ gf_point* gf_computeCubicBezierLineIntersec(gf_curveCP* c, gf_point* line_start,
 
   return result;
 }
+
+uint64_t gf_computeCubicBezierLineIntersecBatch(const gf_curveCP* curves, uint64_t ncurves, const gf_point* line_starts, const gf_point* line_ends, uint64_t nlines, Graphfab::Real* roots, int* counts) {
+  std::vector<CubicBezier2Desc> b;
+  b.reserve(ncurves);
+  for (uint64_t i = 0; i<ncurves; ++i)
+    b.push_back(CubicBezier2Desc(gf_point2Point(curves[i].s), gf_point2Point(curves[i].c1), gf_point2Point(curves[i].c2), gf_point2Point(curves[i].e)));
+
+  std::vector<Line2Desc> l;
+  l.reserve(nlines);
+  for (uint64_t j = 0; j<nlines; ++j)
+    l.push_back(Line2Desc(gf_point2Point(line_starts[j]), gf_point2Point(line_ends[j])));
+
+  if (b.empty() || l.empty())
+    return 0;
+  return intersectCubicBeziersWithLines(&b.front(), ncurves, &l.front(), nlines, roots, counts);
+}
 int gf_arrowheadStyleGetNumVerts(int style) {
   return Graphfab::ArrowheadStyles::getNumVerts(style);
 }
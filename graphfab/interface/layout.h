@@ -355,6 +355,7 @@ _GraphfabExport gf_network* gf_getNetworkp(gf_layoutInfo* l);
 _GraphfabExport void gf_clearNetwork(gf_network* n);
 
 /** @brief Release the network
+ *  @details Also destroys its nodes, reactions and compartments.
  *  @param[in] n The network object
  *  \ingroup C_API
  */
@@ -499,6 +500,17 @@ _GraphfabExport gf_compartment* gf_nw_findCompartmentById(gf_network* n, const c
  */
 _GraphfabExport void gf_nw_rebuildCurves(gf_network* n);
 
+/** @brief Update the curves affected by moved elements
+ *  @details Recalculates control points and clips curves only for reactions
+ *  which moved, or which include a node that moved, since the last update.
+ *  Cheaper than @ref gf_nw_rebuildCurves when only a few elements were
+ *  edited.
+ *  @param[in/out] n The network object
+ *  @return Number of reactions updated
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_nw_recalcDirtyCurves(gf_network* n);
+
 /** @brief Recenter reaction junctions
  *  @param[in] n The network object
  *  \ingroup C_API
@@ -652,6 +664,7 @@ _GraphfabExport void gf_node_setCompartment(gf_node* n, gf_compartment* c);
 _GraphfabExport void gf_clearNode(gf_node* n);
 
 /** @brief Release the node
+ *  @details Only for nodes which do not belong to a network.
  *  @param[in] n The node object
  *  \ingroup C_API
  */
@@ -1104,6 +1117,15 @@ _GraphfabExport void gf_moveNetworkToFirstQuad(gf_layoutInfo* l, double x_disp,
  */
 _GraphfabExport CPoint gf_tf_apply_to_point(gf_transform* tf, CPoint p);
 
+/** @brief Apply transform to an array of points
+ *  @param[in] tf Transform
+ *  @param[in] in Input points
+ *  @param[out] out Output points (may be the same array as @a in)
+ *  @param[in] n Number of points
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_tf_apply_to_points(gf_transform* tf, const CPoint* in, CPoint* out, uint64_t n);
+
 /** @brief Get the scale of the transform
  *  @param[in] tf Transform
  *  \ingroup C_API
@@ -1292,6 +1314,38 @@ _GraphfabExport int gf_writeSBML(const char* filename, gf_SBMLModel* m);
  */
 _GraphfabExport const char* gf_getSBMLwithLayoutStr(gf_SBMLModel* m, gf_layoutInfo* l);
 
+/** @brief Update the layout of the original SBML document in place
+ *  @details Unlike @ref gf_writeSBMLwithLayout, which rebuilds a new document,
+ *  this only touches the first layout of the document @a m was loaded from:
+ *  bounding boxes of existing compartment, species and reaction glyphs are
+ *  updated (text glyphs follow their species), species reference curves are
+ *  replaced and the layout dimensions are set from the canvas. Glyphs are added
+ *  for network elements without one; nothing else in the document is modified.
+ *  A layout is created if the document has none.
+ *  @param[in] m The SBML model, as returned by @ref gf_loadSBMLfile or @ref gf_loadSBMLbuf
+ *  @param[in] l The layout info
+ *  @returns 0 for success, -1 on error (see @ref gf_getLastError)
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_patchSBMLLayout(gf_SBMLModel* m, gf_layoutInfo* l);
+
+/** @brief Patch the original document with @ref gf_patchSBMLLayout and write it
+ *  @param[in] filename The output file
+ *  @param[in] m The SBML model
+ *  @param[in] l The layout info
+ *  @returns 0 for success
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_writeSBMLLayoutPatch(const char* filename, gf_SBMLModel* m, gf_layoutInfo* l);
+
+/** @brief String version of @ref gf_writeSBMLLayoutPatch
+ *  @param[in] m The SBML model
+ *  @param[in] l The layout info
+ *  @return Raw SBML as UTF-8 string (owned by callee), or NULL on error
+ *  \ingroup C_API
+ */
+_GraphfabExport const char* gf_getSBMLLayoutPatchStr(gf_SBMLModel* m, gf_layoutInfo* l);
+
 /** @brief Returns the current version of the library
  *  @return Static string
  *  \ingroup C_API
@@ -1320,6 +1374,23 @@ _GraphfabExport gf_point gf_computeCubicBezierPoint(gf_curveCP* c, Real t);
  */
 _GraphfabExport gf_point* gf_computeCubicBezierLineIntersec(gf_curveCP* c, gf_point* line_start, gf_point* line_end);
 
+/** @brief Compute the intersections between many cubic Beziers and lines
+ *  @details Every curve is tested against every line, and only points
+ *  on the curve (0 <= t <= 1) are reported. Results for curve i and line j
+ *  go to index k = i*nlines + j: counts[k] parameters in ascending order,
+ *  starting at roots[3*k]. Use @ref gf_computeCubicBezierPoint to get the points.
+ *  @param[in] curves Cubic Bezier control points
+ *  @param[in] ncurves The number of curves
+ *  @param[in] line_starts The start of each line
+ *  @param[in] line_ends The end of each line
+ *  @param[in] nlines The number of lines
+ *  @param[out] roots Caller-allocated buffer of 3*ncurves*nlines values
+ *  @param[out] counts Caller-allocated buffer of ncurves*nlines values
+ *  @return The total number of intersections
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_computeCubicBezierLineIntersecBatch(const gf_curveCP* curves, uint64_t ncurves, const gf_point* line_starts, const gf_point* line_ends, uint64_t nlines, Real* roots, int* counts);
+
 /** @brief Get the number of vertices in the arrowhead polygon
  *  @param[in] style Arrowhead style number
  *  @return The arrowhead polygon vertex count
@@ -0,0 +1,379 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/sbmlstream.h"
+#include "graphfab/math/round.h"
+
+#include <string>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Graphfab {
+
+    static const char* const sbmlDefaultCompartment = "graphfab_default_compartment";
+
+    static const char* sbmlRoleName(RxnRoleType role) {
+        switch(role) {
+            case RXN_ROLE_SUBSTRATE:     return "substrate";
+            case RXN_ROLE_PRODUCT:       return "product";
+            case RXN_ROLE_SIDESUBSTRATE: return "sidesubstrate";
+            case RXN_ROLE_SIDEPRODUCT:   return "sideproduct";
+            case RXN_ROLE_MODIFIER:      return "modifier";
+            case RXN_ROLE_ACTIVATOR:     return "activator";
+            case RXN_ROLE_INHIBITOR:     return "inhibitor";
+            default:
+                AN(0, "Unrecognized role");
+                return NULL;
+        }
+    }
+
+    static void sbmlAttr(OutputSink& o, const char* name, const std::string& value) {
+        o.put(' ');
+        o.put(name);
+        o.put("=\"");
+        o.putEscaped(value);
+        o.put('"');
+    }
+
+    static void sbmlAttr(OutputSink& o, const char* name, Real value) {
+        o.put(' ');
+        o.put(name);
+        o.put("=\"");
+        o.putReal(value);
+        o.put('"');
+    }
+
+    static void sbmlPoint(OutputSink& o, const char* indent, const char* tag, const Point& p) {
+        o.put(indent);
+        o.put("<layout:");
+        o.put(tag);
+        sbmlAttr(o, "layout:x", p.x);
+        sbmlAttr(o, "layout:y", p.y);
+        o.put("/>\n");
+    }
+
+    /// Bounding box rounded as in @ref populateSBMLdoc
+    static void sbmlBoundingBox(OutputSink& o, const char* indent, const NetworkElement* e) {
+        std::string in(indent);
+        o.put(in + "<layout:boundingBox>\n");
+        if(e) {
+            o.put(in + "  <layout:position layout:x=\"");
+            o.putInt(sround(e->getMinX()));
+            o.put("\" layout:y=\"");
+            o.putInt(sround(e->getMinY()));
+            o.put("\"/>\n");
+            o.put(in + "  <layout:dimensions layout:width=\"");
+            o.putInt(sround(e->getWidth()));
+            o.put("\" layout:height=\"");
+            o.putInt(sround(e->getHeight()));
+            o.put("\"/>\n");
+        } else {
+            o.put(in + "  <layout:position layout:x=\"0\" layout:y=\"0\"/>\n");
+            o.put(in + "  <layout:dimensions layout:width=\"0\" layout:height=\"0\"/>\n");
+        }
+        o.put(in + "</layout:boundingBox>\n");
+    }
+
+    static void sbmlSpeciesRef(OutputSink& o, const char* tag, const Node* n, bool modifier) {
+        o.put("          <");
+        o.put(tag);
+        sbmlAttr(o, "species", n->getId());
+        if(!modifier)
+            o.put(" stoichiometry=\"1\" constant=\"false\"");
+        o.put("/>\n");
+    }
+
+    static bool sbmlIsReactant(RxnRoleType r) { return r == RXN_ROLE_SUBSTRATE || r == RXN_ROLE_SIDESUBSTRATE; }
+    static bool sbmlIsProduct(RxnRoleType r) { return r == RXN_ROLE_PRODUCT || r == RXN_ROLE_SIDEPRODUCT; }
+    static bool sbmlIsModifier(RxnRoleType r) { return !sbmlIsReactant(r) && !sbmlIsProduct(r); }
+
+    /// Writes the species references of @a r with the given roles as list @a list
+    static void sbmlSpeciesRefList(OutputSink& o, const Graphfab::Reaction* r, const char* list, const char* tag,
+                                   bool (*select)(RxnRoleType)) {
+        bool open = false;
+        for(Graphfab::Reaction::ConstNodeIt i=r->NodesBegin(); i!=r->NodesEnd(); ++i) {
+            if(!select(i->second))
+                continue;
+            if(!open) {
+                o.put("        <");
+                o.put(list);
+                o.put(">\n");
+                open = true;
+            }
+            sbmlSpeciesRef(o, tag, i->first, select == sbmlIsModifier);
+        }
+        if(open) {
+            o.put("        </");
+            o.put(list);
+            o.put(">\n");
+        }
+    }
+
+    void writeSBMLWithLayout(OutputSink& o, Network& net, const Canvas* can, int version) {
+        if(version < 1)
+            version = 1;
+
+        net.rebuildCurves();
+
+        // empty glyph ids are filled in as by populateSBMLdoc
+        uint64 calias=0;
+        for(Network::NodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i) {
+            Node* n = *i;
+            if(n->getGlyph() == "") {
+                if(!n->isAlias())
+                    n->setGlyph(n->getId() + "_Glyph");
+                else {
+                    std::stringstream ss;
+                    ss << n->getId() << "_Alias" << ++calias << "_Glyph";
+                    n->setGlyph(ss.str());
+                }
+            }
+        }
+
+        // compartment of each element (the first one listing it, as findContainingCompartment)
+        std::unordered_map<const NetworkElement*, const Graphfab::Compartment*> container;
+        bool have_default = false;
+        for(Network::ConstCompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i) {
+            const Graphfab::Compartment* c = *i;
+            for(Graphfab::Compartment::ConstEltIt j=c->EltsBegin(); j!=c->EltsEnd(); ++j)
+                container.insert(std::make_pair(*j, c));
+            if(c->getId() == sbmlDefaultCompartment)
+                have_default = true;
+        }
+        bool need_default = false;
+        for(Network::ConstNodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i)
+            if(!container.count(*i))
+                need_default = true;
+
+        std::stringstream core;
+        core << "http://www.sbml.org/sbml/level3/version" << version << "/core";
+
+        o.put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        o.put("<!-- Created by Graphfab -->\n");
+        o.put("<sbml");
+        sbmlAttr(o, "xmlns", core.str());
+        o.put(" xmlns:layout=\"http://www.sbml.org/sbml/level3/version1/layout/version1\"");
+        o.put(" level=\"3\"");
+        sbmlAttr(o, "version", (Real)version);
+        o.put(" layout:required=\"false\">\n");
+
+        o.put("  <model");
+        if(net.isSetId())
+            sbmlAttr(o, "id", net.getId());
+        o.put(">\n");
+
+        // model: compartments
+        if(net.getTotalNumComps() || (need_default && !have_default)) {
+            o.put("    <listOfCompartments>\n");
+            for(Network::ConstCompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i) {
+                o.put("      <compartment");
+                sbmlAttr(o, "id", (*i)->getId());
+                o.put(" size=\"1\" constant=\"false\"/>\n");
+            }
+            if(need_default && !have_default) {
+                o.put("      <compartment sboTerm=\"SBO:0000410\"");
+                sbmlAttr(o, "id", std::string(sbmlDefaultCompartment));
+                o.put(" size=\"1\" constant=\"false\"/>\n");
+            }
+            o.put("    </listOfCompartments>\n");
+        }
+
+        // model: species (aliases share one)
+        if(net.getTotalNumNodes()) {
+            std::unordered_set<std::string> written;
+            o.put("    <listOfSpecies>\n");
+            for(Network::ConstNodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i) {
+                const Node* n = *i;
+                if(!written.insert(n->getId()).second)
+                    continue;
+                o.put("      <species");
+                sbmlAttr(o, "id", n->getId());
+                std::unordered_map<const NetworkElement*, const Graphfab::Compartment*>::const_iterator c = container.find(n);
+                sbmlAttr(o, "compartment", c != container.end() ? c->second->getId() : std::string(sbmlDefaultCompartment));
+                o.put(" initialConcentration=\"0\" hasOnlySubstanceUnits=\"false\" boundaryCondition=\"false\" constant=\"false\"/>\n");
+            }
+            o.put("    </listOfSpecies>\n");
+        }
+
+        // model: reactions
+        if(net.getTotalNumRxns()) {
+            o.put("    <listOfReactions>\n");
+            for(Network::ConstRxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+                const Graphfab::Reaction* r = *i;
+                o.put("      <reaction");
+                sbmlAttr(o, "id", r->getId());
+                o.put(version < 2 ? " reversible=\"false\" fast=\"false\">\n" : " reversible=\"false\">\n");
+                sbmlSpeciesRefList(o, r, "listOfReactants", "speciesReference", sbmlIsReactant);
+                sbmlSpeciesRefList(o, r, "listOfProducts", "speciesReference", sbmlIsProduct);
+                sbmlSpeciesRefList(o, r, "listOfModifiers", "modifierSpeciesReference", sbmlIsModifier);
+                o.put("        <kineticLaw>\n"
+                      "          <math xmlns=\"http://www.w3.org/1998/Math/MathML\">\n"
+                      "            <cn type=\"integer\"> 1 </cn>\n"
+                      "          </math>\n"
+                      "        </kineticLaw>\n"
+                      "      </reaction>\n");
+            }
+            o.put("    </listOfReactions>\n");
+        }
+
+        // layout
+        o.put("    <layout:listOfLayouts xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\">\n");
+        o.put("      <layout:layout layout:id=\"Graphfab_Layout\">\n");
+        o.put("        <layout:dimensions");
+        sbmlAttr(o, "layout:width", can ? can->getWidth() : (Real)1024.);
+        sbmlAttr(o, "layout:height", can ? can->getHeight() : (Real)1024.);
+        o.put("/>\n");
+
+        if(net.getTotalNumComps()) {
+            o.put("        <layout:listOfCompartmentGlyphs>\n");
+            for(Network::ConstCompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i) {
+                const Graphfab::Compartment* c = *i;
+                o.put("          <layout:compartmentGlyph");
+                sbmlAttr(o, "layout:id", c->getGlyph() != "" ? c->getGlyph() : c->getId() + "_Glyph");
+                sbmlAttr(o, "layout:compartment", c->getId());
+                o.put(">\n");
+                sbmlBoundingBox(o, "            ", c);
+                o.put("          </layout:compartmentGlyph>\n");
+            }
+            o.put("        </layout:listOfCompartmentGlyphs>\n");
+        }
+
+        if(net.getTotalNumNodes()) {
+            o.put("        <layout:listOfSpeciesGlyphs>\n");
+            for(Network::ConstNodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i) {
+                const Node* n = *i;
+                o.put("          <layout:speciesGlyph");
+                sbmlAttr(o, "layout:id", n->getGlyph());
+                sbmlAttr(o, "layout:species", n->getId());
+                o.put(">\n");
+                sbmlBoundingBox(o, "            ", n);
+                o.put("          </layout:speciesGlyph>\n");
+            }
+            o.put("        </layout:listOfSpeciesGlyphs>\n");
+        }
+
+        if(net.getTotalNumRxns()) {
+            o.put("        <layout:listOfReactionGlyphs>\n");
+            for(Network::ConstRxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+                const Graphfab::Reaction* r = *i;
+                o.put("          <layout:reactionGlyph");
+                sbmlAttr(o, "layout:id", r->getId() + "_Glyph");
+                sbmlAttr(o, "layout:reaction", r->getId());
+                o.put(">\n");
+                sbmlBoundingBox(o, "            ", NULL);
+
+                uint64 sref=0;
+                Graphfab::Reaction::ConstNodeIt in=r->NodesBegin();
+                Graphfab::Reaction::ConstCurveIt ic=r->CurvesBegin();
+                if(in != r->NodesEnd() && ic != r->CurvesEnd())
+                    o.put("            <layout:listOfSpeciesReferenceGlyphs>\n");
+                for(; in != r->NodesEnd() && ic != r->CurvesEnd(); ++in, ++ic) {
+                    const Node* n = in->first;
+                    const RxnBezier* c = *ic;
+
+                    std::stringstream ss;
+                    ss << r->getId() << "_SpeciesRef" << ++sref;
+
+                    o.put("              <layout:speciesReferenceGlyph");
+                    sbmlAttr(o, "layout:id", ss.str());
+                    sbmlAttr(o, "layout:speciesReference", n->getId());
+                    sbmlAttr(o, "layout:speciesGlyph", n->getGlyph());
+                    o.put(" layout:role=\"");
+                    o.put(sbmlRoleName(in->second));
+                    o.put("\">\n");
+                    sbmlBoundingBox(o, "                ", NULL);
+                    o.put("                <layout:curve>\n"
+                          "                  <layout:listOfCurveSegments>\n"
+                          "                    <layout:curveSegment xsi:type=\"CubicBezier\">\n");
+                    sbmlPoint(o, "                      ", "start", c->s);
+                    sbmlPoint(o, "                      ", "end", c->e);
+                    sbmlPoint(o, "                      ", "basePoint1", c->c1);
+                    sbmlPoint(o, "                      ", "basePoint2", c->c2);
+                    o.put("                    </layout:curveSegment>\n"
+                          "                  </layout:listOfCurveSegments>\n"
+                          "                </layout:curve>\n"
+                          "              </layout:speciesReferenceGlyph>\n");
+                }
+                if(sref)
+                    o.put("            </layout:listOfSpeciesReferenceGlyphs>\n");
+                o.put("          </layout:reactionGlyph>\n");
+            }
+            o.put("        </layout:listOfReactionGlyphs>\n");
+        }
+
+        if(net.getTotalNumNodes()) {
+            o.put("        <layout:listOfTextGlyphs>\n");
+            for(Network::ConstNodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i) {
+                const Node* n = *i;
+                o.put("          <layout:textGlyph");
+                sbmlAttr(o, "layout:id", "t" + n->getGlyph());
+                sbmlAttr(o, "layout:graphicalObject", n->getGlyph());
+                sbmlAttr(o, "layout:text", n->getName() != "" ? n->getName() : n->getId());
+                o.put(">\n");
+                sbmlBoundingBox(o, "            ", n);
+                o.put("          </layout:textGlyph>\n");
+            }
+            o.put("        </layout:listOfTextGlyphs>\n");
+        }
+
+        o.put("      </layout:layout>\n");
+        o.put("    </layout:listOfLayouts>\n");
+        o.put("  </model>\n");
+        o.put("</sbml>\n");
+    }
+
+}
+
+using namespace Graphfab;
+
+int gf_streamSBMLwithLayout(gf_layoutInfo* l, gf_writeCallback write, void* user) {
+    AN(l, "No layout info");
+    Network* net = (Network*)l->net;
+    AN(net, "No network");
+    AT(net->doByteCheck(), "Network has wrong type");
+
+    OutputSink out(write, user);
+    writeSBMLWithLayout(out, *net, (Canvas*)l->canv, l->level == 3 ? l->version : 1);
+    if(!out.flush()) {
+        gf_setError("gf_streamSBMLwithLayout: write failed");
+        return -1;
+    }
+    return 0;
+}
+
+int gf_fwriteSBMLwithLayout(FILE* f, gf_layoutInfo* l) {
+    AN(f, "No file");
+    if(gf_streamSBMLwithLayout(l, OutputSink::writeFILE, f))
+        return -1;
+    return fflush(f) ? -1 : 0;
+}
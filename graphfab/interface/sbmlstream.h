@@ -0,0 +1,97 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file sbmlstream.h
+ * @brief Write SBML with layout directly from a network
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_INTERFACE_SBMLSTREAM_H_
+#define __SBNW_INTERFACE_SBMLSTREAM_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/layout.h"
+#include "graphfab/util/sink.h"
+
+#include <stdio.h>
+
+//-- C methods --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  @brief Write SBML with layout to a callback in a single pass
+ *  @details Produces the same model and layout as
+ *  @ref gf_writeSBMLwithLayout (a minimal model plus one layout), but
+ *  the XML is generated directly from the network instead of building
+ *  an SBML document first, and is passed to @a write in chunks through
+ *  a fixed-size buffer. libSBML is not used, so the output is always
+ *  SBML Level 3 (version 1 unless @a l was loaded from a later version).
+ *  Like @ref gf_writeSBMLwithLayout, rebuilds the curves and assigns
+ *  glyph ids to species which have none.
+ *  @param[in] write Receives the output
+ *  @param[in] user Passed to @a write
+ *  @return 0 on success; -1 if @a write failed
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_streamSBMLwithLayout(gf_layoutInfo* l, gf_writeCallback write, void* user);
+
+/**
+ *  @brief Write SBML with layout to an open file
+ *  @details See @ref gf_streamSBMLwithLayout.
+ *  @return 0 on success
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_fwriteSBMLwithLayout(FILE* f, gf_layoutInfo* l);
+
+#ifdef __cplusplus
+}
+#endif
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include "graphfab/network/network.h"
+#include "graphfab/layout/canvas.h"
+
+namespace Graphfab {
+
+    /// Writes @a net as SBML Level 3 with layout (see @ref gf_streamSBMLwithLayout)
+    _GraphfabExport void writeSBMLWithLayout(OutputSink& out, Network& net, const Canvas* can, int version);
+
+}
+
+#endif
+
+#endif
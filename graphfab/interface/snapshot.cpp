@@ -0,0 +1,703 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/snapshot.h"
+#include "graphfab/util/mappedfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+/* Layout of a snapshot (native byte order):
+ *
+ *   header:      magic "SBNWSNAP", u32 version, u32 byte order mark, u64 body size
+ *   strings:     u32 count, then (u32 length, bytes) for each string
+ *   transforms:  u32 count, then 12 doubles (transform, inverse) for each;
+ *                index 0 is reserved for the identity and is not stored
+ *   body:        source level/version, canvas, network, then the
+ *                compartments, nodes and reactions, and finally the
+ *                network's element list
+ *
+ * Elements refer to each other by position within their section, and to
+ * strings and transforms by table index.
+ */
+
+namespace Graphfab {
+
+    static const char snapshotMagic[8] = {'S','B','N','W','S','N','A','P'};
+    static const uint32 snapshotByteOrder = 0x01020304;
+
+    /// Element kinds in compartment / network element lists
+    enum SnapshotEltKind {
+        SNAPSHOT_ELT_NODE,
+        SNAPSHOT_ELT_RXN,
+        SNAPSHOT_ELT_COMP
+    };
+
+    /// Curve anchor: the reaction centroid (otherwise a node index)
+    static const int32 SNAPSHOT_ANCHOR_RXN = -1;
+    /// Curve anchor: none
+    static const int32 SNAPSHOT_ANCHOR_NONE = -2;
+
+    static RxnRoleType snapshotCurveRole(uint32 type) {
+        switch(type) {
+            case RXN_CURVE_SUBSTRATE: return RXN_ROLE_SUBSTRATE;
+            case RXN_CURVE_PRODUCT:   return RXN_ROLE_PRODUCT;
+            case RXN_CURVE_ACTIVATOR: return RXN_ROLE_ACTIVATOR;
+            case RXN_CURVE_INHIBITOR: return RXN_ROLE_INHIBITOR;
+            case RXN_CURVE_MODIFIER:  return RXN_ROLE_MODIFIER;
+            default:
+                SBNW_THROW(FileReadFailureException, "Snapshot has an unknown curve type", "readSnapshot");
+        }
+    }
+
+    //--CLASS SnapshotWriter--
+
+    class SnapshotWriter {
+        public:
+            explicit SnapshotWriter(Network& net)
+              : net_(net) {
+                for(uint64 i=0; i<net.getTotalNumNodes(); ++i)
+                    nodeIdx_[net.getNodeAt(i)] = (uint32)i;
+                for(uint64 i=0; i<net.getTotalNumRxns(); ++i)
+                    rxnIdx_[net.getRxnAt(i)] = (uint32)i;
+                for(uint64 i=0; i<net.getTotalNumComps(); ++i)
+                    compIdx_[net.getCompAt(i)] = (uint32)i;
+            }
+
+            void write(std::string& out, const Canvas* canv, int level, int version) {
+                writeBody(canv, level, version);
+
+                std::string tables;
+                put(tables, (uint32)strings_.size());
+                for(std::vector<const std::string*>::const_iterator i=strings_.begin(); i!=strings_.end(); ++i) {
+                    put(tables, (uint32)(*i)->size());
+                    tables.append(**i);
+                }
+                put(tables, (uint32)xfs_.size());
+                for(std::vector<SharedTransform>::const_iterator i=xfs_.begin(); i!=xfs_.end(); ++i) {
+                    putAffine(tables, i->getTransform());
+                    putAffine(tables, i->getInverse());
+                }
+
+                out.clear();
+                out.reserve(sizeof(snapshotMagic) + 16 + tables.size() + body_.size());
+                out.append(snapshotMagic, sizeof(snapshotMagic));
+                put(out, SNAPSHOT_VERSION);
+                put(out, snapshotByteOrder);
+                put(out, (uint64)(tables.size() + body_.size()));
+                out.append(tables);
+                out.append(body_);
+            }
+
+        protected:
+            template <class T>
+            static void put(std::string& b, T x) { b.append((const char*)&x, sizeof(x)); }
+
+            static void putAffine(std::string& b, const Affine2d& t) {
+                for(int r=0; r<2; ++r)
+                    for(int c=0; c<3; ++c)
+                        put(b, (double)t.rc(r,c));
+            }
+
+            template <class T>
+            void put(T x) { put(body_, x); }
+
+            void putReal(Real x) { put((double)x); }
+
+            void putPoint(const Point& p) { putReal(p.x); putReal(p.y); }
+
+            void putBox(const Box& b) { putPoint(b.getMin()); putPoint(b.getMax()); }
+
+            void putStr(const std::string& s) {
+                std::unordered_map<std::string, uint32>::iterator i = stringIdx_.find(s);
+                if(i == stringIdx_.end()) {
+                    i = stringIdx_.insert(std::make_pair(s, (uint32)strings_.size())).first;
+                    strings_.push_back(&i->first);
+                }
+                put(i->second);
+            }
+
+            void putXf(const SharedTransform& xf) {
+                const void* key = xf.getSharingKey();
+                if(!key) {
+                    put((uint32)0);
+                    return;
+                }
+                std::unordered_map<const void*, uint32>::iterator i = xfIdx_.find(key);
+                if(i == xfIdx_.end()) {
+                    xfs_.push_back(xf);
+                    i = xfIdx_.insert(std::make_pair(key, (uint32)xfs_.size())).first;
+                }
+                put(i->second);
+            }
+
+            int32 nodeRef(const Node* n) const {
+                std::unordered_map<const NetworkElement*, uint32>::const_iterator i = nodeIdx_.find(n);
+                if(i == nodeIdx_.end())
+                    SBNW_THROW(InternalCheckFailureException, "Reference to a node outside the network", "writeSnapshot");
+                return (int32)i->second;
+            }
+
+            int32 anchorRef(const Point* p, const Reaction* r) const {
+                if(!p)
+                    return SNAPSHOT_ANCHOR_NONE;
+                if(p == &r->_p)
+                    return SNAPSHOT_ANCHOR_RXN;
+                for(Reaction::ConstNodeIt i=r->NodesBegin(); i!=r->NodesEnd(); ++i)
+                    if(p == &i->first->_p)
+                        return nodeRef(i->first);
+                SBNW_THROW(InternalCheckFailureException, "Curve anchored to a foreign point", "writeSnapshot");
+            }
+
+            void putEltRef(const NetworkElement* e) {
+                std::unordered_map<const NetworkElement*, uint32>::const_iterator i;
+                if((i = nodeIdx_.find(e)) != nodeIdx_.end())
+                    put((uint32)SNAPSHOT_ELT_NODE);
+                else if((i = rxnIdx_.find(e)) != rxnIdx_.end())
+                    put((uint32)SNAPSHOT_ELT_RXN);
+                else if((i = compIdx_.find(e)) != compIdx_.end())
+                    put((uint32)SNAPSHOT_ELT_COMP);
+                else
+                    SBNW_THROW(InternalCheckFailureException, "Element is not part of the network", "writeSnapshot");
+                put(i->second);
+            }
+
+            void writeBody(const Canvas* canv, int level, int version) {
+                put((int32)level);
+                put((int32)version);
+
+                put((uint32)(canv ? 1 : 0));
+                putReal(canv ? canv->getWidth() : 0.);
+                putReal(canv ? canv->getHeight() : 0.);
+
+                putStr(net_.getId());
+                putStr(net_.getName());
+                put((uint32)net_.isLayoutSpecified());
+                putXf(net_.getSharedTransform());
+                putXf(net_.getSharedEltTransform());
+
+                put((uint64)net_.getTotalNumComps());
+                put((uint64)net_.getTotalNumNodes());
+                put((uint64)net_.getTotalNumRxns());
+
+                for(uint64 k=0; k<net_.getTotalNumComps(); ++k) {
+                    Compartment* c = net_.getCompAt(k);
+                    putStr(c->getId());
+                    putStr(c->getName());
+                    putStr(c->getGlyph());
+                    putBox(c->getLocalExtents());
+                    putReal(c->restArea());
+                    put((uint32)c->isCentroidSet());
+                    put((uint32)c->isLocked());
+                    putXf(c->getSharedTransform());
+                    put((uint64)c->getNElts());
+                    for(Compartment::ConstEltIt i=c->EltsBegin(); i!=c->EltsEnd(); ++i)
+                        putEltRef(*i);
+                }
+
+                for(uint64 k=0; k<net_.getTotalNumNodes(); ++k) {
+                    Node* n = net_.getNodeAt(k);
+                    putStr(n->getId());
+                    putStr(n->getName());
+                    putStr(n->getGlyph());
+                    putPoint(n->_p);
+                    putBox(n->getLocalExtents());
+                    put((uint32)n->numUses());
+                    put((uint32)n->isAlias());
+                    put((uint32)n->isCentroidSet());
+                    put((uint32)n->isLocked());
+                    put((uint32)n->excludeFromSubgraphEnum());
+                    put((uint64)n->get_i());
+                    put((uint64)n->_deg);
+                    put((uint64)n->_ldeg);
+                    if(n->_comp) {
+                        std::unordered_map<const NetworkElement*, uint32>::const_iterator i = compIdx_.find(n->_comp);
+                        put(i != compIdx_.end() ? (int32)i->second : (int32)-1);
+                    } else
+                        put((int32)-1);
+                    putXf(n->getSharedTransform());
+                }
+
+                for(uint64 k=0; k<net_.getTotalNumRxns(); ++k) {
+                    Reaction* r = net_.getRxnAt(k);
+                    putStr(r->getId());
+                    putStr(r->getName());
+                    putPoint(r->_p);
+                    put((uint32)r->isCentroidSet());
+                    put((uint32)r->isLocked());
+                    put((uint32)r->isDirty());
+                    put((uint64)r->_deg);
+                    put((uint64)r->_ldeg);
+                    putXf(r->getSharedTransform());
+
+                    put((uint64)r->numSpecies());
+                    for(Reaction::ConstNodeIt i=r->NodesBegin(); i!=r->NodesEnd(); ++i) {
+                        put(nodeRef(i->first));
+                        put((uint32)i->second);
+                    }
+
+                    put((uint64)(r->CurvesEnd() - r->CurvesBegin()));
+                    for(Reaction::ConstCurveIt i=r->CurvesBegin(); i!=r->CurvesEnd(); ++i) {
+                        const RxnBezier* c = *i;
+                        put((uint32)c->getRole());
+                        put(anchorRef(c->as, r));
+                        put(anchorRef(c->ae, r));
+                        put(c->ns ? nodeRef(c->ns) : (int32)-1);
+                        put(c->ne ? nodeRef(c->ne) : (int32)-1);
+                        putPoint(c->s);
+                        putPoint(c->c1);
+                        putPoint(c->c2);
+                        putPoint(c->e);
+                    }
+                }
+
+                put((uint64)net_.getNElts());
+                for(Network::ConstEltIt i=net_.EltsBegin(); i!=net_.EltsEnd(); ++i)
+                    putEltRef(*i);
+            }
+
+            Network& net_;
+            std::string body_;
+            std::unordered_map<std::string, uint32> stringIdx_;
+            std::vector<const std::string*> strings_;
+            std::unordered_map<const void*, uint32> xfIdx_;
+            std::vector<SharedTransform> xfs_;
+            std::unordered_map<const NetworkElement*, uint32> nodeIdx_;
+            std::unordered_map<const NetworkElement*, uint32> rxnIdx_;
+            std::unordered_map<const NetworkElement*, uint32> compIdx_;
+    };
+
+    //--CLASS SnapshotReader--
+
+    class SnapshotReader {
+        public:
+            SnapshotReader(const char* data, size_t size)
+              : p_(data), end_(data + size), net_(NULL), canv_(NULL), added_(false) {}
+
+            /// Frees the partially built network and canvas if reading failed
+            ~SnapshotReader() {
+                delete canv_;
+                if(net_) {
+                    if(!added_) {
+                        // hand every element to the network so it gets destroyed
+                        for(size_t k=0; k<comps_.size(); ++k)
+                            net_->addCompartment(comps_[k]);
+                        for(size_t k=0; k<nodes_.size(); ++k)
+                            net_->addNode(nodes_[k]);
+                        for(size_t k=0; k<rxns_.size(); ++k)
+                            net_->addReaction(rxns_[k]);
+                    }
+                    net_->hierarchRelease();
+                    delete net_;
+                }
+            }
+
+            Network* read(Canvas** canv, int* level, int* version) {
+                readHeader();
+                readTables();
+                readBody(level, version);
+                *canv = canv_;
+                canv_ = NULL;
+                Network* net = net_;
+                net_ = NULL;
+                return net;
+            }
+
+        protected:
+            static void fail(const char* msg) {
+                SBNW_THROW(FileReadFailureException, msg, "readSnapshot");
+            }
+
+            void need(size_t n) {
+                if((size_t)(end_ - p_) < n)
+                    fail("Snapshot is truncated");
+            }
+
+            template <class T>
+            T get() {
+                need(sizeof(T));
+                T x;
+                memcpy(&x, p_, sizeof(T));
+                p_ += sizeof(T);
+                return x;
+            }
+
+            Real getReal() { return (Real)get<double>(); }
+
+            Point getPoint() {
+                Real x = getReal();
+                return Point(x, getReal());
+            }
+
+            Box getBox() {
+                Point min = getPoint();
+                Point max = getPoint();
+                if(!(min.x <= max.x && min.y <= max.y))
+                    fail("Snapshot has an invalid box");
+                return Box(min, max);
+            }
+
+            /// Read an index, which must be less than @a n
+            uint32 getIdx(uint64 n) {
+                uint32 i = get<uint32>();
+                if(i >= n)
+                    fail("Snapshot has an index out of range");
+                return i;
+            }
+
+            /// Read a count of records; each takes at least one byte
+            uint64 getCount() {
+                uint64 n = get<uint64>();
+                if(n > (uint64)(end_ - p_))
+                    fail("Snapshot is truncated");
+                return n;
+            }
+
+            const std::string& getStr() { return strings_.at(getIdx(strings_.size())); }
+
+            const SharedTransform& getXf() { return xfs_.at(getIdx(xfs_.size())); }
+
+            Node* getNodeRef() {
+                int32 i = get<int32>();
+                if(i < 0 || (uint64)i >= nodes_.size())
+                    fail("Snapshot has a node index out of range");
+                return nodes_[i];
+            }
+
+            Point* getAnchor(Reaction* r) {
+                int32 i = get<int32>();
+                if(i == SNAPSHOT_ANCHOR_NONE)
+                    return NULL;
+                if(i == SNAPSHOT_ANCHOR_RXN)
+                    return &r->_p;
+                if(i < 0 || (uint64)i >= nodes_.size())
+                    fail("Snapshot has a node index out of range");
+                return &nodes_[i]->_p;
+            }
+
+            Node* getOptNodeRef() {
+                int32 i = get<int32>();
+                if(i == -1)
+                    return NULL;
+                if(i < 0 || (uint64)i >= nodes_.size())
+                    fail("Snapshot has a node index out of range");
+                return nodes_[i];
+            }
+
+            NetworkElement* getEltRef() {
+                uint32 kind = get<uint32>();
+                switch(kind) {
+                    case SNAPSHOT_ELT_NODE: return nodes_[getIdx(nodes_.size())];
+                    case SNAPSHOT_ELT_RXN:  return rxns_[getIdx(rxns_.size())];
+                    case SNAPSHOT_ELT_COMP: return comps_[getIdx(comps_.size())];
+                    default:
+                        fail("Snapshot has an unknown element kind");
+                }
+                return NULL;
+            }
+
+            void readHeader() {
+                need(sizeof(snapshotMagic));
+                if(memcmp(p_, snapshotMagic, sizeof(snapshotMagic)))
+                    fail("Not an SBNW snapshot");
+                p_ += sizeof(snapshotMagic);
+                uint32 version = get<uint32>();
+                if(get<uint32>() != snapshotByteOrder)
+                    fail("Snapshot was written on a machine with a different byte order");
+                if(version != SNAPSHOT_VERSION)
+                    fail("Unsupported snapshot version");
+                uint64 size = get<uint64>();
+                if(size != (uint64)(end_ - p_))
+                    fail("Snapshot is truncated");
+            }
+
+            void readTables() {
+                uint32 nstrings = get<uint32>();
+                if(nstrings > (uint64)(end_ - p_))
+                    fail("Snapshot is truncated");
+                strings_.reserve(nstrings);
+                for(uint32 k=0; k<nstrings; ++k) {
+                    uint32 len = get<uint32>();
+                    need(len);
+                    strings_.push_back(std::string(p_, len));
+                    p_ += len;
+                }
+
+                uint32 nxfs = get<uint32>();
+                need((uint64)nxfs*12*sizeof(double));
+                xfs_.resize(nxfs + 1);
+                for(uint32 k=1; k<=nxfs; ++k) {
+                    Affine2d t = getAffine();
+                    xfs_[k] = SharedTransform(t, getAffine());
+                }
+            }
+
+            Affine2d getAffine() {
+                Real e[6];
+                for(int k=0; k<6; ++k)
+                    e[k] = getReal();
+                return Affine2d(e[0], e[1], e[2], e[3], e[4], e[5]);
+            }
+
+            void readBody(int* level, int* version) {
+                *level = get<int32>();
+                *version = get<int32>();
+
+                bool have_canv = get<uint32>();
+                Real w = getReal(), h = getReal();
+                if(have_canv)
+                    canv_ = new Canvas(w, h);
+
+                net_ = new Network();
+                net_->setId(getStr());
+                net_->setName(getStr());
+                net_->setLayoutSpecified(get<uint32>());
+                net_->shareTransform(getXf(), false);
+                uint32 eltxf = getIdx(xfs_.size());
+                if(eltxf) {
+                    // make the network's copy the one the elements share
+                    net_->setTransform(xfs_[eltxf].getTransform());
+                    net_->setInverseTransform(xfs_[eltxf].getInverse());
+                    xfs_[eltxf] = net_->getSharedEltTransform();
+                }
+
+                comps_.resize(getCount());
+                for(size_t k=0; k<comps_.size(); ++k)
+                    comps_[k] = net_->newCompartment();
+                nodes_.resize(getCount());
+                for(size_t k=0; k<nodes_.size(); ++k)
+                    nodes_[k] = net_->newNode();
+                rxns_.resize(getCount());
+                for(size_t k=0; k<rxns_.size(); ++k)
+                    rxns_[k] = net_->newReaction();
+
+                for(size_t k=0; k<comps_.size(); ++k) {
+                    Compartment* c = comps_[k];
+                    c->setId(getStr());
+                    c->setName(getStr());
+                    c->setGlyph(getStr());
+                    c->setRestExtents(getBox());
+                    c->recalcExtents();
+                    c->setRestArea(getReal());
+                    c->setCentroidSetFlag(get<uint32>());
+                    if(get<uint32>())
+                        c->lock();
+                    c->shareTransform(getXf(), false);
+                    for(uint64 n=getCount(); n; --n)
+                        c->addElt(getEltRef());
+                }
+
+                for(size_t k=0; k<nodes_.size(); ++k) {
+                    Node* n = nodes_[k];
+                    n->setId(getStr());
+                    n->setName(getStr());
+                    n->setGlyph(getStr());
+                    Point p = getPoint();
+                    n->setExtents(getBox());
+                    n->_p = p;
+                    n->numUses() = get<uint32>();
+                    n->setAlias(get<uint32>());
+                    n->setCentroidSetFlag(get<uint32>());
+                    if(get<uint32>())
+                        n->lock();
+                    if(get<uint32>())
+                        n->setExcludeFromSubgraphEnum();
+                    n->set_i((size_t)get<uint64>());
+                    n->_deg = get<uint64>();
+                    n->_ldeg = get<uint64>();
+                    int32 comp = get<int32>();
+                    if(comp >= 0) {
+                        if((uint64)comp >= comps_.size())
+                            fail("Snapshot has a compartment index out of range");
+                        n->_comp = comps_[comp];
+                    }
+                    n->shareTransform(getXf(), false);
+                }
+
+                std::vector<uint64> nodedeg(nodes_.size()), nodeldeg(nodes_.size());
+                for(size_t k=0; k<nodes_.size(); ++k) {
+                    nodedeg[k] = nodes_[k]->_deg;
+                    nodeldeg[k] = nodes_[k]->_ldeg;
+                }
+
+                for(size_t k=0; k<rxns_.size(); ++k) {
+                    Reaction* r = rxns_[k];
+                    r->setId(getStr());
+                    r->setName(getStr());
+                    r->setCentroid(getPoint());
+                    r->setCentroidSetFlag(get<uint32>());
+                    if(get<uint32>())
+                        r->lock();
+                    bool dirty = get<uint32>();
+                    uint64 deg = get<uint64>();
+                    uint64 ldeg = get<uint64>();
+                    const SharedTransform& xf = getXf();
+
+                    for(uint64 n=getCount(); n; --n) {
+                        Node* s = getNodeRef();
+                        uint32 role = get<uint32>();
+                        if(role > RXN_ROLE_INHIBITOR)
+                            fail("Snapshot has an unknown species role");
+                        r->addSpeciesRef(s, (RxnRoleType)role);
+                    }
+
+                    for(uint64 n=getCount(); n; --n) {
+                        RxnBezier* c = r->addCurve(snapshotCurveRole(get<uint32>()));
+                        c->as = getAnchor(r);
+                        c->ae = getAnchor(r);
+                        c->ns = getOptNodeRef();
+                        c->ne = getOptNodeRef();
+                        c->s = getPoint();
+                        c->c1 = getPoint();
+                        c->c2 = getPoint();
+                        c->e = getPoint();
+                    }
+
+                    r->_deg = deg;
+                    r->_ldeg = ldeg;
+                    if(!dirty)
+                        r->clearDirtyFlag();
+                    r->shareTransform(xf, true);
+                }
+
+                // addSpeciesRef counted the connections again
+                for(size_t k=0; k<nodes_.size(); ++k) {
+                    nodes_[k]->_deg = nodedeg[k];
+                    nodes_[k]->_ldeg = nodeldeg[k];
+                }
+
+                // every element must be listed exactly once
+                uint64 nelts = getCount();
+                if(nelts != comps_.size() + nodes_.size() + rxns_.size())
+                    fail("Snapshot has an inconsistent element list");
+                std::vector<NetworkElement*> order;
+                order.reserve(nelts);
+                std::unordered_set<NetworkElement*> seen;
+                for(uint64 n=0; n<nelts; ++n) {
+                    order.push_back(getEltRef());
+                    if(!seen.insert(order.back()).second)
+                        fail("Snapshot has an inconsistent element list");
+                }
+
+                if(p_ != end_)
+                    fail("Snapshot has trailing data");
+
+                added_ = true;
+                for(std::vector<NetworkElement*>::iterator i=order.begin(); i!=order.end(); ++i) {
+                    NetworkElement* e = *i;
+                    switch(e->getType()) {
+                        case NET_ELT_TYPE_SPEC: net_->addNode((Node*)e); break;
+                        case NET_ELT_TYPE_RXN:  net_->addReaction((Reaction*)e); break;
+                        default:                net_->addCompartment((Compartment*)e); break;
+                    }
+                }
+            }
+
+            const char* p_;
+            const char* end_;
+            Network* net_;
+            /// Canvas read with the body; handed to the caller only on success
+            Canvas* canv_;
+            /// True once the elements belong to @ref net_
+            bool added_;
+            std::vector<std::string> strings_;
+            std::vector<SharedTransform> xfs_;
+            std::vector<Compartment*> comps_;
+            std::vector<Node*> nodes_;
+            std::vector<Reaction*> rxns_;
+    };
+
+    void writeSnapshot(std::string& out, Network& net, const Canvas* canv, int level, int version) {
+        SnapshotWriter w(net);
+        w.write(out, canv, level, version);
+    }
+
+    Network* readSnapshot(const char* data, size_t size, Canvas** canv, int* level, int* version) {
+        SnapshotReader r(data, size);
+        return r.read(canv, level, version);
+    }
+
+}
+
+using namespace Graphfab;
+
+int gf_saveSnapshot(const char* filename, gf_layoutInfo* l) {
+    if(!l || !l->net) {
+        gf_setError("gf_saveSnapshot: no network");
+        return -1;
+    }
+
+    try {
+        std::string data;
+        writeSnapshot(data, *(Network*)l->net, (Canvas*)l->canv, l->level, l->version);
+
+        FILE* f = fopen(filename, "wb");
+        if(!f) {
+            gf_setError("gf_saveSnapshot: unable to open file for writing");
+            return -1;
+        }
+        size_t written = fwrite(data.data(), 1, data.size(), f);
+        if(fclose(f) || written != data.size()) {
+            gf_setError("gf_saveSnapshot: failed to write file");
+            return -1;
+        }
+    } catch(const Exception& e) {
+        gf_setError(e.getReport().c_str());
+        return -1;
+    }
+    return 0;
+}
+
+gf_layoutInfo* gf_loadSnapshot(const char* filename) {
+    try {
+        MappedFile file(filename);
+
+        gf_layoutInfo* l = (gf_layoutInfo*)malloc(sizeof(gf_layoutInfo));
+        l->cont = NULL;
+        Canvas* canv = NULL;
+        try {
+            l->net = readSnapshot(file.getData(), file.getSize(), &canv, &l->level, &l->version);
+        } catch(...) {
+            free(l);
+            throw;
+        }
+        l->canv = canv;
+        return l;
+    } catch(const Exception& e) {
+        gf_setError(e.getReport().c_str());
+        return NULL;
+    }
+}
@@ -0,0 +1,117 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file snapshot.h
+ * @brief Binary snapshots of laid-out networks
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_INTERFACE_SNAPSHOT_H_
+#define __SBNW_INTERFACE_SNAPSHOT_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/interface/layout.h"
+
+#include <stdint.h>
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include "graphfab/network/network.h"
+#include "graphfab/layout/canvas.h"
+
+#include <string>
+
+namespace Graphfab {
+
+    /// Version written by @ref writeSnapshot
+    const uint32 SNAPSHOT_VERSION = 1;
+
+    /**
+     * @brief Serialize a network and canvas into @a out
+     * @details The snapshot holds the nodes (including aliases),
+     * reactions and their curves, compartments, the element
+     * transforms and the canvas size. Ids, names and glyphs go into
+     * a string table so each distinct string is stored once.
+     * @param[in] canv May be NULL
+     */
+    _GraphfabExport void writeSnapshot(std::string& out, Network& net, const Canvas* canv, int level, int version);
+
+    /**
+     * @brief Rebuild a network from a snapshot in memory
+     * @details Throws @ref FileReadFailureException if the data is not
+     * a snapshot, was written by a newer version, or is truncated.
+     * @param[out] canv Set to a new canvas, or NULL if none was saved
+     * @param[out] level SBML level of the source document
+     * @param[out] version SBML version of the source document
+     * @return A new network (caller owns)
+     */
+    _GraphfabExport Network* readSnapshot(const char* data, size_t size, Canvas** canv, int* level, int* version);
+
+}
+
+#endif
+
+//-- C methods --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  @brief Save the network and canvas of @a l to a binary snapshot
+ *  @details Snapshots are much faster to reload than SBML, but only
+ *  hold the layout: there is no SBML document, so the result of
+ *  @ref gf_loadSnapshot cannot be passed to @ref gf_writeSBMLwithLayout.
+ *  The format is native-endian and is meant as a cache, not an
+ *  exchange format.
+ *  @return 0 on success; otherwise sets the last error
+ *  @sa gf_getLastError
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_saveSnapshot(const char* filename, gf_layoutInfo* l);
+
+/**
+ *  @brief Load a snapshot written by @ref gf_saveSnapshot
+ *  @details The file is memory-mapped and the network rebuilt directly
+ *  from it, without libSBML. Free the result with
+ *  @ref gf_freeLayoutInfoHierarch.
+ *  @return The layout, or NULL on failure (sets the last error)
+ *  \ingroup C_API
+ */
+_GraphfabExport gf_layoutInfo* gf_loadSnapshot(const char* filename);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,135 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/bhtree.h"
+#include "graphfab/math/min_max.h"
+
+namespace Graphfab {
+
+    //--CLASS BHTree--
+
+    void BHTree::build(const std::vector<Point>& pos, const std::vector<Real>& deg, const std::vector<Real>& dim) {
+        AT(pos.size() == deg.size() && pos.size() == dim.size(), "Array size mismatch");
+
+        pos_ = &pos;
+        deg_ = &deg;
+        dim_ = &dim;
+
+        cells_.clear();
+        next_.assign(pos.size(), -1);
+
+        if(pos.empty())
+            return;
+
+        // bounding square of all elements
+        Point lo(pos[0]), hi(pos[0]);
+        for(uint64 j=1; j<pos.size(); ++j) {
+            lo = Point::emin(lo, pos[j]);
+            hi = Point::emax(hi, pos[j]);
+        }
+
+        Cell root;
+        root.center = (lo + hi)*0.5;
+        root.half = max(max(hi.x - lo.x, hi.y - lo.y)*0.5, mindim_) + 1.;
+        root.count = 0;
+        root.deg = root.dim = 0;
+        root.child[0] = root.child[1] = root.child[2] = root.child[3] = -1;
+        root.first = -1;
+        root.leaf = true;
+        cells_.reserve(2*pos.size()+1);
+        cells_.push_back(root);
+
+        for(uint64 j=0; j<pos.size(); ++j)
+            insert((int)j);
+
+        for(std::vector<Cell>::iterator i=cells_.begin(); i!=cells_.end(); ++i) {
+            if(i->count > 0)
+                i->com = i->sum*(1./i->count);
+        }
+    }
+
+    void BHTree::accumulate(int c, int j) {
+        Cell& cell = cells_[c];
+        cell.sum += (*pos_)[j];
+        cell.count += 1.;
+        cell.deg += (*deg_)[j];
+        cell.dim += (*dim_)[j];
+    }
+
+    int BHTree::childFor(int c, const Point& p) {
+        int q = (p.x >= cells_[c].center.x ? 1 : 0) | (p.y >= cells_[c].center.y ? 2 : 0);
+        if(cells_[c].child[q] < 0) {
+            Cell ch;
+            ch.half = cells_[c].half*0.5;
+            ch.center = cells_[c].center + Point(q & 1 ? ch.half : -ch.half, q & 2 ? ch.half : -ch.half);
+            ch.count = 0;
+            ch.deg = ch.dim = 0;
+            ch.child[0] = ch.child[1] = ch.child[2] = ch.child[3] = -1;
+            ch.first = -1;
+            ch.leaf = true;
+            // may reallocate, so don't hold refs across this
+            cells_.push_back(ch);
+            cells_[c].child[q] = (int)cells_.size()-1;
+        }
+        return cells_[c].child[q];
+    }
+
+    void BHTree::insert(int j) {
+        const Point& p = (*pos_)[j];
+        int c = 0;
+        for(;;) {
+            accumulate(c, j);
+            if(cells_[c].leaf) {
+                if(cells_[c].first < 0) {
+                    // empty leaf
+                    cells_[c].first = j;
+                    return;
+                }
+                if(cells_[c].half < mindim_) {
+                    // (nearly) coincident elements share the leaf
+                    next_[j] = cells_[c].first;
+                    cells_[c].first = j;
+                    return;
+                }
+                // split: push the current occupant down one level
+                int k = cells_[c].first;
+                cells_[c].first = -1;
+                cells_[c].leaf = false;
+                int q = childFor(c, (*pos_)[k]);
+                accumulate(q, k);
+                cells_[q].first = k;
+            }
+            c = childFor(c, p);
+        }
+    }
+
+}
@@ -0,0 +1,133 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file bhtree.h
+ * @brief Barnes-Hut quadtree used to approximate repulsion in the layout algorithm
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_BHTREE_H_
+#define __SBNW_LAYOUT_BHTREE_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/point.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief Barnes-Hut quadtree
+     * @details Partitions the centroids of the network elements into a
+     * quadtree. Each cell stores the number of elements it contains along
+     * with the sum of their positions, degrees and sizes so that a whole
+     * cell can stand in for its contents when it is far enough away.
+     * Elements are referred to by their index in the input arrays.
+     */
+    class BHTree {
+        public:
+            /// A square region of the tree
+            struct Cell {
+                /// Geometric center of the cell
+                Point center;
+                /// Half the width of the cell
+                Real half;
+                /// Mean position of the contents (valid after @ref build)
+                Point com;
+                /// Sum of the positions of the contents
+                Point sum;
+                /// Number of elements contained
+                Real count;
+                /// Sum of degrees of the contents
+                Real deg;
+                /// Sum of the sizes (max of width/height) of the contents
+                Real dim;
+                /// Children by quadrant (-1 if absent)
+                int child[4];
+                /// First element in a leaf (-1 for empty leaves & internal cells)
+                int first;
+                /// True if the cell has no children
+                bool leaf;
+            };
+
+            BHTree()
+                : mindim_(1e-3) {}
+
+            /** @brief Build the tree
+             * @param[in] pos Element centroids
+             * @param[in] deg Element degrees
+             * @param[in] dim Element sizes
+             * @details All three arrays must be the same length.
+             */
+            void build(const std::vector<Point>& pos, const std::vector<Real>& deg, const std::vector<Real>& dim);
+
+            /// Number of cells in the tree (the root is cell 0)
+            uint64 getNumCells() const { return cells_.size(); }
+
+            const Cell& getCell(uint64 i) const { return cells_[i]; }
+
+            /// Next element sharing a leaf with element @a j (-1 if none)
+            int getNextInLeaf(int j) const { return next_[j]; }
+
+            /// Cells smaller than this are not subdivided further
+            Real getMinCellSize() const { return mindim_; }
+
+            void setMinCellSize(Real d) { mindim_ = d; }
+
+        protected:
+            /// Insert element @a j starting at the root
+            void insert(int j);
+
+            /// Add element @a j to the sums stored in cell @a c
+            void accumulate(int c, int j);
+
+            /// Get the child of @a c containing @a p, creating it if necessary
+            int childFor(int c, const Point& p);
+
+            std::vector<Cell> cells_;
+            std::vector<int> next_;
+
+            // weak refs to the input arrays (valid during build)
+            const std::vector<Point>* pos_;
+            const std::vector<Real>* deg_;
+            const std::vector<Real>* dim_;
+
+            Real mindim_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -42,11 +42,14 @@
 #include "graphfab/layout/point.h"
 #include "graphfab/math/transform.h"
 #include "graphfab/layout/arrowhead.h"
+#include "graphfab/layout/box.h"
+#include "graphfab/math/geom.h"
 
 //-- C++ code --
 #ifdef __cplusplus
 
 #include <string>
+#include <algorithm>
 
 #include <iostream>
 
@@ -72,6 +75,8 @@ namespace Graphfab {
     class RxnBezier {
         public:
             RxnBezier() {
+              as = ae = NULL;
+              owns = owne = 0;
               ns = ne = NULL;
             }
 
@@ -109,10 +114,10 @@ namespace Graphfab {
             /// Start & end point resp., control points
             Point s, e, c1, c2;
 
-            Point getTransformedS() const { return tf_*s; }
-            Point getTransformedE() const { return tf_*e; }
-            Point getTransformedC1() const { return tf_*c1; }
-            Point getTransformedC2() const { return tf_*c2; }
+            Point getTransformedS() const { return xf_.getTransform()*s; }
+            Point getTransformedE() const { return xf_.getTransform()*e; }
+            Point getTransformedC1() const { return xf_.getTransform()*c1; }
+            Point getTransformedC2() const { return xf_.getTransform()*c2; }
 
             virtual Point getCentroidCP() const = 0;
 
@@ -172,7 +177,7 @@ namespace Graphfab {
                 v = (e - c2).normed() * 5.;
               Point u = v.dextro();
 
-              a.setTransform(tf_*Affine2d::fromBasis(u, v, e));
+              a.setTransform(xf_.getTransform()*Affine2d::fromBasis(u, v, e));
               a.setInverseTransform(a.getTransform().inv());
             }
 
@@ -181,7 +186,7 @@ namespace Graphfab {
 //               Point v = (e - s).normed() * 5.;
 //               Point u = v.dextro();
 //
-//               a.setTransform(tf_*Affine2d::fromBasis(u, v, e));
+//               a.setTransform(xf_.getTransform()*Affine2d::fromBasis(u, v, e));
 //               a.setInverseTransform(a.getTransform().inv());
 //             }
 
@@ -192,13 +197,16 @@ namespace Graphfab {
               return result;
             }
 
-            Affine2d getTransform() const { return tf_; }
+            Affine2d getTransform() const { return xf_.getTransform(); }
 
-            void setTransform(const Affine2d& tf, bool recurse = true) { tf_ = tf; }
+            void setTransform(const Affine2d& tf, bool recurse = true) { xf_.setTransform(tf); }
 
-            Affine2d getInverseTransform() const { return itf_; }
+            Affine2d getInverseTransform() const { return xf_.getInverse(); }
 
-            void setInverseTransform(const Affine2d& itf, bool recurse = true) { itf_ = itf; }
+            void setInverseTransform(const Affine2d& itf, bool recurse = true) { xf_.setInverse(itf); }
+
+            /// Refer to the reaction's transform instead of holding a copy
+            void shareTransform(const SharedTransform& xf) { xf_ = xf; }
 
             virtual ArrowheadStyle getArrowheadStyle() const = 0;
 
@@ -217,7 +225,79 @@ namespace Graphfab {
               return std::make_pair(s1,r2);
             }
 
+            /** Parameter at which @ref clipForwardToBoxBisect (@a forward) or
+              * @ref clipReverseToBoxBisect splits the curve
+              * @details The crossings with @a b are computed in closed form and
+              * the bisection is replayed against them. Once only one crossing
+              * is within its reach, and it is the kind the bisection converges
+              * to, that exact parameter is returned. Otherwise the replay runs
+              * to the same stopping point as the bisection, using cheap scalar
+              * evaluation of the curve.
+            */
+            Real calcBoxClipParam(const Box& b, bool forward, const Real cutoff=0.1) const {
+              const Real tmin = forward ? 0.5 : 0.;
+              const Real tmax = forward ? 1. : 0.5;
+              CubicBezierBoxIntersection x(CubicBezier2Desc(s, c1, c2, e), b, tmin, tmax);
+              const int n = x.getNumIntersections();
+              const bool in0 = b.contains(clipForward(tmin).first);
+
+              // power basis
+              const Real ax = -s.x + 3.*c1.x - 3.*c2.x + e.x, ay = -s.y + 3.*c1.y - 3.*c2.y + e.y;
+              const Real bx = 3.*s.x - 6.*c1.x + 3.*c2.x,     by = 3.*s.y - 6.*c1.y + 3.*c2.y;
+              const Real cx = 3.*(c1.x - s.x),                cy = 3.*(c1.y - s.y);
+              // previous point
+              Real px = forward ? e.x : s.x, py = forward ? e.y : s.y;
+
+              Real t = forward ? 0.75 : 0.25;
+              Real delta = 0.125;
+              Real tlast = t;
+              Real distance;
+              int k = 0;
+              do {
+                // only one crossing left within reach (t - 2*delta, t + 2*delta)?
+                int nreach = 0, last = -1;
+                for (int i=0; i<n; ++i)
+                  if (std::abs(x.getIntersection(i) - t) < 2.*delta) {
+                    ++nreach;
+                    last = i;
+                  }
+                if (nreach == 1 && (forward ? x.isEntering(last) : x.isLeaving(last)))
+                  return x.getIntersection(last);
+
+                Real qx = ((ax*t + bx)*t + cx)*t + s.x;
+                Real qy = ((ay*t + by)*t + cy)*t + s.y;
+                distance = (qx-px)*(qx-px) + (qy-py)*(qy-py);
+                px = qx;
+                py = qy;
+                tlast = t;
+
+                // inside the box at t? (state after the last crossing before t)
+                bool in = in0;
+                for (int i=0; i<n && x.getIntersection(i) < t; ++i)
+                  if (x.isEntering(i))
+                    in = true;
+                  else if (x.isLeaving(i))
+                    in = false;
+                // move towards the end when outside (forward) / inside (reverse)
+                bool up = forward ? !in : in;
+                t += up ? delta : -delta;
+                delta *= 0.5;
+              } while (distance > cutoff*cutoff && ++k < 64);
+              return tlast;
+            }
+
+            /** Clips the end of the curve where it enters @a b (for t in
+              * [0.5, 1]). Gives the same result as @ref clipForwardToBoxBisect
+              * but splits at the exact crossing instead of iterating on the curve
+            */
             void clipForwardToBox(const Box& b, const Real cutoff=0.1) {
+              std::pair<Point,Point> r = clipForward(calcBoxClipParam(b, true, cutoff));
+              e = r.first;
+              c2 = r.second;
+            }
+
+            /// Clip the end of the curve by bisection until the step is below @a cutoff
+            void clipForwardToBoxBisect(const Box& b, const Real cutoff=0.1) {
               Real t = 0.75;
               Real delta=0.125;
               Point ep=e, c2p;
@@ -256,7 +336,17 @@ namespace Graphfab {
               return std::make_pair(s1,r1);
             }
 
+            /** Clips the start of the curve where it leaves @a b (for t in
+              * [0, 0.5]); see @ref clipForwardToBox
+            */
             void clipReverseToBox(const Box& b, const Real cutoff=0.1) {
+              std::pair<Point,Point> r = clipForward(calcBoxClipParam(b, false, cutoff));
+              s = r.first;
+              c1 = r.second;
+            }
+
+            /// Clip the start of the curve by bisection until the step is below @a cutoff
+            void clipReverseToBoxBisect(const Box& b, const Real cutoff=0.1) {
               Real t = 0.25;
               Real delta=0.125;
               Point sp=s, c1p;
@@ -281,10 +371,8 @@ namespace Graphfab {
             }
 
 
-            /// Transform
-            Affine2d tf_;
-            /// Inverse transform
-            Affine2d itf_;
+            /// Transform & inverse (usually shared with the reaction)
+            SharedTransform xf_;
         protected:
     };
 
@@ -32,16 +32,27 @@
 #include "graphfab/core/SagittariusCore.h"
 #include "graphfab/layout/fr.h"
 #include "graphfab/layout/canvas.h"
+#include "graphfab/layout/bhtree.h"
+#include "graphfab/layout/frkernel.h"
+#include "graphfab/layout/layoutcache.h"
+#include "graphfab/layout/multilevel.h"
+#include "graphfab/layout/pack.h"
+#include "graphfab/layout/spatialgrid.h"
 #include "graphfab/math/rand_unif.h"
 #include "graphfab/math/min_max.h"
 #include "graphfab/math/dist.h"
 #include "graphfab/math/transform.h"
+#include "graphfab/util/threadpool.h"
 
 #if SBNW_USE_MAGICK
 #include "graphfab/draw/magick.h"
 #endif
 
 #include <sstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <set>
 
 //#include <math.h>
 
@@ -61,13 +72,69 @@ void gf_getLayoutOptDefaults(fr_options* opt) {
     opt->enable_comps = 0;
     opt->prerandomize = 0;
     opt->padding = 15;
+    opt->repulsion = GF_REPULSION_EXACT;
+    opt->theta = 0.8;
+    opt->parallel = 0;
+    opt->threads = 0;
+    opt->multilevel = 0;
+    opt->tolerance = 0.;
+    opt->adaptive = 0;
+    opt->maxiter = 0;
+    opt->maxtime = 0.;
+    opt->components = 0;
+    opt->warmstart = GF_WARMSTART_OFF;
+    opt->cutoff = 0.;
+    opt->correction = 0;
+    opt->random_seed = 0;
 }
 
 void gf_layout_setStiffness(fr_options* opt, double k) {
     opt->k = k;
 }
 
-void gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l) {
+void gf_layout_setBarnesHut(fr_options* opt, double theta) {
+    opt->repulsion = GF_REPULSION_BARNES_HUT;
+    opt->theta = theta;
+}
+
+void gf_layout_setGridRepulsion(fr_options* opt, double cutoff, int correction) {
+    opt->repulsion = GF_REPULSION_GRID;
+    opt->cutoff = cutoff;
+    opt->correction = correction;
+}
+
+void gf_layout_setThreads(fr_options* opt, int threads) {
+    opt->parallel = 1;
+    opt->threads = threads;
+}
+
+void gf_layout_setMultilevel(fr_options* opt, int multilevel) {
+    opt->multilevel = multilevel;
+}
+
+void gf_layout_setConvergence(fr_options* opt, double tolerance, int adaptive) {
+    opt->tolerance = tolerance;
+    opt->adaptive = adaptive;
+}
+
+void gf_layout_setBudget(fr_options* opt, int maxiter, double maxtime) {
+    opt->maxiter = maxiter;
+    opt->maxtime = maxtime;
+}
+
+void gf_layout_setComponents(fr_options* opt, int components) {
+    opt->components = components;
+}
+
+void gf_layout_setWarmStart(fr_options* opt, int warmstart) {
+    opt->warmstart = warmstart;
+}
+
+void gf_layout_setRandomSeed(fr_options* opt, uint64_t seed) {
+    opt->random_seed = seed;
+}
+
+uint64_t gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l) {
     using namespace Graphfab;
     
     Network* net = (Network*)l->net;
@@ -75,14 +142,30 @@ void gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l) {
     Canvas* can = (Canvas*)l->canv;
     AN(can, "No canvas");
     
-    if(opt.prerandomize)
-        //TODO: use canvas width, height
-        net->randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)));
-    
-	FruchtermanReingold(opt, *net, can, l);
+	return FruchtermanReingoldCached(opt, *net, can, l);
+}
+
+uint64_t gf_doIncrementalLayout(fr_options opt, gf_network* n, gf_node** nodes, uint64_t nnodes, gf_reaction** rxns, uint64_t nrxns, int hops) {
+    using namespace Graphfab;
+
+    AN(n, "No network");
+    Network* net = (Network*)n->n;
+    AN(net, "No network");
+
+    std::vector<NetworkElement*> changed;
+    for(uint64_t i=0; i<nnodes; ++i) {
+        AN(nodes[i] && nodes[i]->n, "No node");
+        changed.push_back((Node*)nodes[i]->n);
+    }
+    for(uint64_t i=0; i<nrxns; ++i) {
+        AN(rxns[i] && rxns[i]->r, "No reaction");
+        changed.push_back((Reaction*)rxns[i]->r);
+    }
+
+    return FruchtermanReingoldIncremental(opt, *net, changed, hops);
 }
 
-void gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c) {
+uint64_t gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c) {
     using namespace Graphfab;
     
     AN(n, "No network");
@@ -95,11 +178,7 @@ void gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c) {
         AN(can, "No canvas");
     }
     
-    if(opt.prerandomize)
-        //TODO: use canvas width, height
-        net->randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)));
-    
-    FruchtermanReingold(opt, *net, can, NULL);
+    return FruchtermanReingoldCached(opt, *net, can, NULL);
 }
 
 namespace Graphfab {
@@ -172,27 +251,237 @@ namespace Graphfab {
         v.addDelta(-f);
     }
     
-    // apply the attraction force
-    void do_attForce(NetworkElement& u, NetworkElement& v, Real k) {
-        Point delta(u.centroidDisplacementFrom(v).normed());
-        //std::cout << "delta: " << delta << "\n";
+    /** @brief Repulsion exerted on an element by a body
+     * @details The body is either a single element or a cell of the Barnes-Hut
+     * tree standing in for @a count elements. Uses the same stiffness
+     * adjustment as @ref do_repulForce, with the degree and size of the body
+     * taken as the mean over its contents. The body must not coincide with
+     * the element.
+     * @param[in] disp   Displacement from the body to the element
+     * @param[in] degsum Degree of the element plus (mean) degree of the body
+     * @param[in] dimsum Size of the element plus (mean) size of the body
+     * @param[in] count  Number of elements in the body
+     */
+    Point calc_repulBody(const Point& disp, Real degsum, Real dimsum, Real count, Real k) {
+        Real d = max(disp.mag(), 0.1);
+        Real adjk = k*log(degsum+2) + dimsum/4;
+        return disp.normed() * (count*calc_fr(adjk, d));
+    }
 
-//         std::cerr << "attr bet " << eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << "\n";
+    // repulsion on body i due to body j
+    inline Point calc_repulPair(const FRBodies& b, uint64 i, uint64 j, Real k, uint64 num, uint64 salt) {
+        Point disp = b.pos(i) - b.pos(j);
+        if(disp.mag2() < 1e-6)
+            return frCoincidentKick(salt, i, j, num);
+        return calc_repulBody(disp, b.deg[i] + b.deg[j], b.dim[i] + b.dim[j], 1., k);
+    }
+
+    // repulsion on body i from all other bodies, approximated using the quadtree
+    Point calc_repulBarnesHut(const BHTree& tree, const FRBodies& b, uint64 i, Real theta, Real k, uint64 num, uint64 salt, std::vector<int>& stack) {
+        Point p = b.pos(i);
+        Point f(0,0);
+
+        stack.clear();
+        stack.push_back(0);
+        while(!stack.empty()) {
+            const BHTree::Cell& c = tree.getCell(stack.back());
+            stack.pop_back();
+
+            if(c.leaf) {
+                for(int j=c.first; j>=0; j=tree.getNextInLeaf(j)) {
+                    if(j == (int)i)
+                        continue;
+                    f += calc_repulPair(b, i, j, k, num, salt);
+                }
+                continue;
+            }
+
+            Point disp = p - c.com;
+            bool inside = fabs(p.x - c.center.x) <= c.half && fabs(p.y - c.center.y) <= c.half;
+
+            if(!inside && 2.*c.half < theta*disp.mag()) {
+                // far enough away to treat as a single body
+                f += calc_repulBody(disp, b.deg[i] + c.deg/c.count, b.dim[i] + c.dim/c.count, c.count, k);
+            } else {
+                for(int q=0; q<4; ++q)
+                    if(c.child[q] >= 0)
+                        stack.push_back(c.child[q]);
+            }
+        }
+
+        return f;
+    }
+
+    // range of the grid repulsion
+    Real calc_cutoff(const fr_options& opt, Real k) {
+        return opt.cutoff > 0. ? opt.cutoff : 4.*k;
+    }
+
+    // above this grid occupancy (e.g. early on, before the layout has spread
+    // out) a neighbourhood holds a good fraction of the network and Barnes-Hut
+    // is used instead
+    static const Real frGridMaxOccupancy = 16.;
+
+    // repulsion on body i from the bodies closer than the cutoff
+    Point calc_repulGrid(const SpatialGrid& grid, const FRBodies& b, uint64 i, Real cutoff, Real k, uint64 num, uint64 salt, std::vector<int>& near) {
+        Point p = b.pos(i);
+        Point f(0,0);
+        Real c2 = cutoff*cutoff;
+
+        near.clear();
+        grid.getNeighbours(p, near);
+        for(std::vector<int>::const_iterator j=near.begin(); j!=near.end(); ++j) {
+            if(*j == (int)i || (p - b.pos(*j)).mag2() >= c2)
+                continue;
+            f += calc_repulPair(b, i, *j, k, num, salt);
+        }
+
+        return f;
+    }
+
+    // forward
+    void do_repulBarnesHut(fr_options& opt, Network& net, const FRBodies& b, Real k, uint64 num, uint64 salt);
+
+    // compute the repulsion on all species & reactions within the cutoff using a uniform grid
+    // (@a b must be gathered)
+    void do_repulGrid(fr_options& opt, Network& net, const FRBodies& b, Real k, uint64 num, uint64 salt) {
+        Real cutoff = calc_cutoff(opt, k);
+        std::vector<Point> pos;
+        b.getPositions(pos);
+        SpatialGrid grid;
+        grid.build(pos, cutoff);
+
+        if(grid.getOccupancy() > frGridMaxOccupancy) {
+            do_repulBarnesHut(opt, net, b, k, num, salt);
+            return;
+        }
+
+        std::vector<int> near;
+        for(uint64 i=0; i<b.size(); ++i)
+            b.elts[i]->addDelta(calc_repulGrid(grid, b, i, cutoff, k, num, salt, near));
+    }
+
+    // compute the repulsion on all species & reactions using a Barnes-Hut quadtree
+    // (@a b must be gathered)
+    void do_repulBarnesHut(fr_options& opt, Network& net, const FRBodies& b, Real k, uint64 num, uint64 salt) {
+        std::vector<Point> pos;
+        b.getPositions(pos);
+        BHTree tree;
+        tree.build(pos, b.deg, b.dim);
+
+        std::vector<int> stack;
+        for(uint64 i=0; i<b.size(); ++i)
+            b.elts[i]->addDelta(calc_repulBarnesHut(tree, b, i, opt.theta, k, num, salt, stack));
+    }
+
+    /** @brief Computes the repulsion on a range of bodies
+     * @details Each body's force goes into its own slot of
+     * @ref FRBodies::dvx / @ref FRBodies::dvy and is summed in a fixed order
+     * (ascending index for the pairwise method, tree order for Barnes-Hut,
+     * cell order for the grid), so the result does not depend on how the
+     * range is divided among threads. The pairwise method walks the other
+     * bodies in tiles so that a tile of positions stays in cache for a whole
+     * block of rows.
+     */
+    class RepulsionTask : public RangeTask {
+        public:
+            RepulsionTask(FRBodies& b, const BHTree* tree, const SpatialGrid* grid, Real theta, Real cutoff, Real k, uint64 num, uint64 salt)
+                : b_(b), tree_(tree), grid_(grid), theta_(theta), cutoff_(cutoff), k_(k), num_(num), salt_(salt) {}
+
+            void run(uint64 begin, uint64 end) {
+                if(grid_) {
+                    std::vector<int> near;
+                    for(uint64 i=begin; i<end; ++i) {
+                        Point f = calc_repulGrid(*grid_, b_, i, cutoff_, k_, num_, salt_, near);
+                        b_.dvx[i] = f.x;
+                        b_.dvy[i] = f.y;
+                    }
+                    return;
+                }
+
+                if(tree_) {
+                    std::vector<int> stack;
+                    for(uint64 i=begin; i<end; ++i) {
+                        Point f = calc_repulBarnesHut(*tree_, b_, i, theta_, k_, num_, salt_, stack);
+                        b_.dvx[i] = f.x;
+                        b_.dvy[i] = f.y;
+                    }
+                    return;
+                }
+
+                const uint64 n = b_.size();
+                for(uint64 jb=0; jb<n; jb+=tile)
+                    frRepulsionBlock(b_, begin, end, jb, jb+tile < n ? jb+tile : n, k_, num_, salt_);
+            }
+
+            /// Number of bodies per tile
+            static const uint64 tile = 256;
+
+        protected:
+            FRBodies& b_;
+            const BHTree* tree_;
+            const SpatialGrid* grid_;
+            Real theta_, cutoff_, k_;
+            uint64 num_, salt_;
+    };
+
+    // interactions involving compartments (only used when the species/reaction
+    // repulsion is computed without the pairwise loop)
+    void do_compForces(fr_options& opt, Network& net, Real k, uint64 num) {
+        if(!opt.enable_comps)
+            return;
+
+        for(Network::CompIt i=net.CompsBegin(); i!=net.CompsEnd(); ++i) {
+            Compartment* c = *i;
+
+            // comp-comp interaction
+            for(Network::CompIt j=i+1; j!=net.CompsEnd(); ++j)
+                do_repulForce(*c, **j, k, num);
+
+            // reactions & comps don't interact
+            for(Network::NodeIt j=net.NodesBegin(); j!=net.NodesEnd(); ++j) {
+                Node* v = *j;
+                if(c->contains(v))
+                    // node inside a compartment
+                    do_internalForce(v, *c, k);
+                else
+                    do_repulForce(*c, *v, k, num);
+            }
+        }
+    }
+
+    /** @brief Compute the attraction force between a reaction and one of its species
+     * @details Stores the force on each element in @a fu and @a fv.
+     * @return False if the elements coincide (no force)
+     */
+    bool calc_attForce(const NetworkElement& u, const NetworkElement& v, Real k, Point& fu, Point& fv) {
+        Point delta(u.centroidDisplacementFrom(v).normed());
 
         Real ep = 1.e-6;
         
         Real d = u.centroidDisplacementFrom(v).mag();
         
         if(d > ep) {
-            //Real invd = 1./d;
-            
             //Real adjk = k*log((Real)u.degree()+v.degree()+2);
             Real adjk = (k*log((Real)u.degree()+v.degree()+2) + (max(v.getWidth(), v.getHeight()) + max(u.getWidth(), u.getHeight()))/4);
-            u.addDelta(-delta * calc_fa(u.getType() == NET_ELT_TYPE_RXN ? k : adjk, d));
+            fu = -delta * calc_fa(u.getType() == NET_ELT_TYPE_RXN ? k : adjk, d);
+            fv =  delta * calc_fa(v.getType() == NET_ELT_TYPE_RXN ? k : adjk, d);
+            return true;
+        }
+        return false;
+    }
+
+    // apply the attraction force
+    void do_attForce(NetworkElement& u, NetworkElement& v, Real k) {
+//         std::cerr << "attr bet " << eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << "\n";
+
+        Point fu, fv;
+        if(calc_attForce(u, v, k, fu, fv)) {
+            u.addDelta(fu);
             if (dumpForces_)
-              std::cerr << "attr force bet "<< eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << ": " << (delta * calc_fa(u.getType() == NET_ELT_TYPE_RXN ? k : adjk, d)).mag()/d << "\n";
+              std::cerr << "attr force bet "<< eltTypeToStr(u.getType()) << " & " << eltTypeToStr(v.getType()) << ": " << fu.mag()/u.centroidDisplacementFrom(v).mag() << "\n";
 
-            v.addDelta( delta * calc_fa(v.getType() == NET_ELT_TYPE_RXN ? k : adjk, d));
+            v.addDelta(fv);
         }
     }
 
@@ -207,13 +496,8 @@ namespace Graphfab {
       u.addDelta( -delta * adjk );
     }
     
-    // single interation
-    void FRSingle(fr_options& opt, Network& net, Box bound, Real T, Real k, uint64 num) {
-        net.resetActivity();
-        
-        net.updateExtents();
-        
-        // repulsive forces
+    // compute the repulsion between every pair of elements
+    void do_repulExact(fr_options& opt, Network& net, Real k, uint64 num) {
         for(uint64 i=0; i<net.getNElts(); ++i) {
             //NetworkElement* u = *i;
             NetworkElement* u = net.getElt(i);;
@@ -256,6 +540,274 @@ namespace Graphfab {
                 do_repulForce(*u, *v, k, num);
             }
         }
+    }
+    
+    /** @brief Computes the attraction along a range of edges
+     * @details The forces are stored per edge and applied afterwards in the
+     * same order as the serial mode.
+     */
+    class AttractionTask : public RangeTask {
+        public:
+            AttractionTask(const FRBodies& b, Real k, std::vector<Point>& fu, std::vector<Point>& fv, std::vector<char>& active)
+                : b_(b), k_(k), fu_(fu), fv_(fv), active_(active) {}
+
+            void run(uint64 begin, uint64 end) {
+                frAttractionEdges(b_, begin, end, k_, &fu_[0], &fv_[0], &active_[0]);
+            }
+
+        protected:
+            const FRBodies& b_;
+            Real k_;
+            std::vector<Point>& fu_;
+            std::vector<Point>& fv_;
+            std::vector<char>& active_;
+    };
+
+    /// Steps which only touch the element or body they are applied to
+    class ElementStepTask : public RangeTask {
+        public:
+            enum Step {
+                /// Reset activity & recompute extents (elements)
+                STEP_RESET,
+                /// Copy centroids & sizes (bodies)
+                STEP_GATHER,
+                /// Apply gravity to species (bodies)
+                STEP_GRAVITY,
+                /// Hand the accumulated forces back (bodies)
+                STEP_SCATTER,
+                /// Cap the displacement & move (elements)
+                STEP_MOVE
+            };
+
+            ElementStepTask(Step step, const fr_options& opt, Network& net, FRBodies& b, Real T, Real k)
+                : step_(step), opt_(opt), net_(net), b_(b), T_(T), k_(k) {}
+
+            void run(uint64 begin, uint64 end) {
+                switch(step_) {
+                    case STEP_RESET:
+                        for(uint64 i=begin; i<end; ++i) {
+                            NetworkElement* u = net_.getElt(i);
+                            u->resetActivity();
+                            u->recalcExtents();
+                        }
+                        break;
+                    case STEP_GATHER:
+                        b_.gather(begin, end);
+                        break;
+                    case STEP_GRAVITY:
+                        for(uint64 i=begin; i<end; ++i) {
+                            if (!b_.spec[i])
+                                continue;
+                            // same as do_gravity
+                            Point delta = b_.pos(i) - Point(opt_.baryx, opt_.baryy);
+                            if (delta.mag() < 1e-2)
+                                continue;
+                            Point f = -delta * (opt_.grav / k_);
+                            b_.dvx[i] += f.x;
+                            b_.dvy[i] += f.y;
+                        }
+                        break;
+                    case STEP_SCATTER:
+                        b_.scatter(begin, end);
+                        break;
+                    case STEP_MOVE:
+                        for(uint64 i=begin; i<end; ++i) {
+                            NetworkElement* u = net_.getElt(i);
+                            u->capDelta2(T_*T_);
+                            u->doMotion(T_);
+                        }
+                        break;
+                }
+            }
+
+        protected:
+            Step step_;
+            const fr_options& opt_;
+            Network& net_;
+            FRBodies& b_;
+            Real T_, k_;
+    };
+
+    // total squared force on the species & reactions
+    Real calc_energy(Network& net) {
+        Real energy = 0.;
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* u = net.getElt(i);
+            if(u->getType() != NET_ELT_TYPE_COMP)
+                energy += u->getDelta().mag2();
+        }
+        return energy;
+    }
+
+    // largest distance moved by a species or reaction since positions were saved in @a prev
+    Real calc_maxDisplacement(Network& net, const std::vector<Point>& prev) {
+        Real d2 = 0.;
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* u = net.getElt(i);
+            if(u->getType() != NET_ELT_TYPE_COMP)
+                d2 = max(d2, (u->getCentroid() - prev.at(i)).mag2());
+        }
+        return sqrt(d2);
+    }
+
+    void savePositions(Network& net, std::vector<Point>& prev) {
+        prev.resize(net.getNElts());
+        for(uint64 i=0; i<net.getNElts(); ++i)
+            prev[i] = net.getElt(i)->getCentroid();
+    }
+
+    /** @brief Compute the forces of one iteration on the thread pool
+     * @details Works on the structure-of-arrays copy @a b of the species &
+     * reactions (see @ref FRBodies); the forces are handed back to the
+     * elements at the end.
+     */
+    void calc_forcesParallel(fr_options& opt, Network& net, FRBodies& b, Real k, uint64 num, uint64 salt, ThreadPool& pool) {
+        // per-element chunk size
+        const uint64 grain = 256;
+        // not used until the elements move
+        const Real T = 0.;
+
+        ElementStepTask reset(ElementStepTask::STEP_RESET, opt, net, b, T, k);
+        pool.parallelFor(net.getNElts(), grain, reset);
+
+        ElementStepTask gather(ElementStepTask::STEP_GATHER, opt, net, b, T, k);
+        pool.parallelFor(b.size(), grain, gather);
+
+        // repulsive forces
+        BHTree tree;
+        SpatialGrid grid;
+        bool bh = opt.repulsion == GF_REPULSION_BARNES_HUT;
+        bool gr = opt.repulsion == GF_REPULSION_GRID;
+        Real cutoff = calc_cutoff(opt, k);
+        if(bh || gr) {
+            std::vector<Point> pos;
+            b.getPositions(pos);
+            if(gr) {
+                grid.build(pos, cutoff);
+                if(grid.getOccupancy() > frGridMaxOccupancy) {
+                    gr = false;
+                    bh = true;
+                }
+            }
+            if(bh)
+                tree.build(pos, b.deg, b.dim);
+        }
+
+        RepulsionTask repulsion(b, bh ? &tree : NULL, gr ? &grid : NULL, opt.theta, cutoff, k, num, salt);
+        pool.parallelFor(b.size(), bh || gr ? 64 : RepulsionTask::tile/4, repulsion);
+
+        do_compForces(opt, net, k, num);
+
+        // attractive forces
+        uint64 nedges = b.eu.size();
+        std::vector<Point> fu(nedges), fv(nedges);
+        std::vector<char> active(nedges, 0);
+        if(nedges) {
+            AttractionTask attraction(b, k, fu, fv, active);
+            pool.parallelFor(nedges, grain, attraction);
+        }
+
+        for(uint64 edge=0; edge<nedges; ++edge) {
+            if(!active[edge])
+                continue;
+            b.dvx[b.eu[edge]] += fu[edge].x;
+            b.dvy[b.eu[edge]] += fu[edge].y;
+            b.dvx[b.ev[edge]] += fv[edge].x;
+            b.dvy[b.ev[edge]] += fv[edge].y;
+        }
+
+        if (opt.grav >= 5.) {
+            ElementStepTask gravity(ElementStepTask::STEP_GRAVITY, opt, net, b, T, k);
+            pool.parallelFor(b.size(), grain, gravity);
+        }
+
+        ElementStepTask scatter(ElementStepTask::STEP_SCATTER, opt, net, b, T, k);
+        pool.parallelFor(b.size(), grain, scatter);
+    }
+
+    /** @brief Single iteration on the thread pool
+     * @return The energy (total squared force)
+     */
+    Real FRSingleParallel(fr_options& opt, Network& net, FRBodies& b, Real T, Real k, uint64 num, uint64 salt, ThreadPool& pool) {
+        // per-element chunk size
+        const uint64 grain = 256;
+
+        calc_forcesParallel(opt, net, b, k, num, salt, pool);
+
+        Real energy = calc_energy(net);
+
+        ElementStepTask move(ElementStepTask::STEP_MOVE, opt, net, b, T, k);
+        pool.parallelFor(net.getNElts(), grain, move);
+
+        return energy;
+    }
+
+    /** @brief Coarse phases of the multilevel scheme
+     * @details Coarsens the species/reaction graph, lays out the coarsest
+     * level, prolongs & refines down to level 1 and moves the elements to
+     * the prolonged positions of level 0, leaving the final refinement to
+     * the regular iterations.
+     * @param[out] k0 Mean natural spring length of the network
+     * @return False if the network is too small to coarsen
+     */
+    bool do_multilevel(fr_options& opt, Network& net, FRBodies& b, uint64 seed, Real& k0) {
+        net.updateExtents();
+        b.gather(0, b.size());
+
+        // mean of the adjusted stiffness used by do_attForce
+        k0 = 0.;
+        for(uint64 edge=0; edge<b.eu.size(); ++edge) {
+            uint64 u = b.eu[edge], v = b.ev[edge];
+            k0 += opt.k*b.logdeg[b.ideg[u] + b.ideg[v]] + (b.dim[u] + b.dim[v])/4;
+        }
+        k0 = b.eu.size() ? k0/b.eu.size() : opt.k;
+
+        MultilevelLayout ml;
+        ml.setSeed(seed);
+        if(opt.grav >= 5.)
+            ml.setGravity(opt.grav, Point(opt.baryx, opt.baryy));
+        ml.coarsen(b, k0);
+        uint64 top = ml.getNumLevels()-1;
+        if(!top)
+            return false;
+
+        uint64 nc = ml.getLevel(top).size();
+        ml.layoutLevel(top, 100.*log((Real)nc+2), ml.getSpringLength(top)*sqrt((Real)nc));
+        for(uint64 l=top; l>0; --l) {
+            ml.prolong(l);
+            if(l > 1)
+                ml.layoutLevel(l-1, 30, 2.*ml.getSpringLength(l-1));
+        }
+
+        const FRLevel& g = ml.getLevel(0);
+        for(uint64 i=0; i<b.size(); ++i)
+            if(!b.elts[i]->isLocked())
+                b.elts[i]->setCentroid(g.pos[i]);
+
+        return true;
+    }
+
+    /** @brief Compute the forces of one iteration into the element deltas
+     * @details @a b is only used (and refreshed) for the Barnes-Hut & grid
+     * repulsion; it is built once per layout
+     */
+    void calc_forces(fr_options& opt, Network& net, FRBodies& b, Real k, uint64 num, uint64 salt) {
+        net.resetActivity();
+        
+        net.updateExtents();
+        
+        // repulsive forces
+        if(opt.repulsion == GF_REPULSION_BARNES_HUT) {
+            b.gather(0, b.size());
+            do_repulBarnesHut(opt, net, b, k, num, salt);
+            do_compForces(opt, net, k, num);
+        } else if(opt.repulsion == GF_REPULSION_GRID) {
+            b.gather(0, b.size());
+            do_repulGrid(opt, net, b, k, num, salt);
+            do_compForces(opt, net, k, num);
+        } else {
+            do_repulExact(opt, net, k, num);
+        }
         
         // attractive forces
         for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
@@ -274,6 +826,12 @@ namespace Graphfab {
             }
           }
         }
+    }
+
+    Real FRSingle(fr_options& opt, Network& net, FRBodies& b, Box bound, Real T, Real k, uint64 num, uint64 salt) {
+        calc_forces(opt, net, b, k, num, salt);
+
+        Real energy = calc_energy(net);
         
         net.capDeltas(T);
         
@@ -285,23 +843,43 @@ namespace Graphfab {
         /*if(opt.boundary) {
             net.doNodeBoxContactForce(bound, T, 10.);
         }*/
+
+        return energy;
     }
     
-    void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l) {
-        //AT(feenableexcept(FE_DIVBYZERO) != -1);
-        Box bound;
-        if(opt.boundary) {
-            AN(can, "Boundary specified but no canvas");
-            bound = can->getBox();
-            if(bound.canShrink(20.))
-                bound.shrink_(20.);
-            if(opt.autobary) {
-                //adjust barycenter
-                opt.baryx = can->getWidth() *0.5;
-                opt.baryy = can->getHeight()*0.5;
-            }
+    /** @brief Starting temperature for a layout that is already in place
+     * @details Evaluates the forces once at the current positions and
+     * returns the median distance the movable species & reactions would
+     * like to travel. A settled layout gives a small value, a scrambled one
+     * a large value.
+     */
+    Real calc_warmTemperature(fr_options& opt, Network& net, FRBodies& b, Real k, uint64 num, uint64 salt, ThreadPool* pool) {
+        if(pool)
+            calc_forcesParallel(opt, net, b, k, num, salt, *pool);
+        else
+            calc_forces(opt, net, b, k, num, salt);
+
+        std::vector<Real> disp;
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* u = net.getElt(i);
+            if(u->getType() != NET_ELT_TYPE_COMP && !u->isLocked())
+                disp.push_back(u->getDelta().mag());
         }
-        
+        net.resetActivity();
+        if(disp.empty())
+            return 0.;
+
+        std::nth_element(disp.begin(), disp.begin() + disp.size()/2, disp.end());
+        return disp[disp.size()/2];
+    }
+
+    /** @brief Run the iterations on one network
+     * @param[in] seed Drives the random numbers of all but the serial
+     * pairwise path (which calls rand() directly, as it always has)
+     * @param[in] Tinit Initial temperature (0 = derive from the network size)
+     * @return The number of iterations run
+     */
+    uint64 FRLayout(fr_options& opt, Network& net, Canvas* can, gf_layoutInfo* l, Box bound, uint64 seed, Real Tinit = 0.) {
         uint64 num = net.getTotalNumPts();
         uint64 m = 100.*log((Real)num+2);
         
@@ -310,9 +888,42 @@ namespace Graphfab {
         Real k = opt.k;
         
         // initial temperature
-        Real Ti = 1000.*log((Real)num+2);
+        Real Ti = Tinit > 0. ? Tinit : 1000.*log((Real)num+2);
         // Current temp
         Real T;
+
+        ThreadPool* pool = NULL;
+        FRBodies bodies;
+        if(opt.parallel || opt.multilevel || opt.repulsion != GF_REPULSION_EXACT)
+            bodies.build(net);
+        if(opt.parallel)
+            pool = new ThreadPool(opt.threads > 0 ? (uint64)opt.threads : 0);
+
+        if(opt.multilevel) {
+            Real k0;
+            if(do_multilevel(opt, net, bodies, frMix64(~seed), k0)) {
+                // only refine the prolonged layout
+                m = m/4 > 30 ? m/4 : 30;
+                Ti = 2.*k0;
+            }
+        }
+        
+        if(opt.warmstart && Tinit <= 0.) {
+            // start no hotter than the current layout asks for and shorten
+            // the schedule accordingly (the full one at Ti)
+            Real Tw = calc_warmTemperature(opt, net, bodies, k, num, frMix64(~seed), pool);
+            if(Tw < Ti) {
+                Real frac = log(max(Tw, (Real)1.)/0.25)/log(Ti/0.25);
+                m = m*frac*frac;
+                if(m < 30)
+                    m = 30;
+                Ti = max(Tw, (Real)1.);
+            }
+        }
+
+        // a cap: never lengthens the (possibly shortened) schedule
+        if(opt.maxiter > 0)
+            m = min(m, (uint64)opt.maxiter);
         
         // time
         Real t = 0.;
@@ -323,18 +934,75 @@ namespace Graphfab {
         
         Real ep = 1.e-6;
         
-        dumpForces_ = false;
+        // components are laid out concurrently, so only write the flag if it was set
+        if (dumpForces_)
+            dumpForces_ = false;
+
+        // convergence tracking
+        std::vector<Point> prev;
+        Real energy, prevEnergy = 0.;
+        uint64 progress = 0, stall = 0, iters = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        T = Ti;
+
+        // the grid mode's periodic full pass
+        fr_options gopt(opt);
+        gopt.repulsion = GF_REPULSION_BARNES_HUT;
+        int correction = opt.correction ? opt.correction : 10;
 
         for(uint64 z=0; z<m; ++z) {
-            T = Ti*pow(e, -alpha*t);
-            t += dt;
+            if(!opt.adaptive) {
+                T = Ti*pow(e, -alpha*t);
+                t += dt;
+            }
 //             std::cerr << "T = " << T << "\n";
 
             // dump forces for last iteration
 //             if (z == m-1)
 //               dumpForces_ = true;
+
+            if(opt.tolerance > 0.)
+                savePositions(net, prev);
             
-            FRSingle(opt, net, bound, T, k, num);
+            fr_options& iopt = opt.repulsion == GF_REPULSION_GRID && correction > 0 && !(z % correction) ? gopt : opt;
+            if(pool)
+                energy = FRSingleParallel(iopt, net, bodies, T, k, num, frMix64(seed + z), *pool);
+            else
+                energy = FRSingle(iopt, net, bodies, bound, T, k, num, frMix64(seed + z));
+            ++iters;
+
+            bool done = false;
+
+            if(opt.adaptive) {
+                // cool while the energy is not improving, reheat slightly after
+                // a run of improvements (Hu, Mathematica Journal '05)
+                if(z && energy < prevEnergy) {
+                    if(++progress >= 5) {
+                        progress = 0;
+                        T = min(T/0.9, Ti);
+                    }
+                } else {
+                    progress = 0;
+                    T *= 0.9;
+                }
+                if(T < 0.25)
+                    done = true;
+            }
+
+            if(opt.tolerance > 0.) {
+                if(calc_maxDisplacement(net, prev) < opt.tolerance*k)
+                    done = true;
+                if(z && fabs(energy - prevEnergy) <= opt.tolerance*prevEnergy)
+                    ++stall;
+                else
+                    stall = 0;
+                if(stall >= 10)
+                    done = true;
+            }
+            prevEnergy = energy;
+
+            if(opt.maxtime > 0. && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= opt.maxtime)
+                done = true;
             
 //             std::cout << "Network:\n";
 //             net.dump(std::cout, 0);
@@ -363,12 +1031,395 @@ namespace Graphfab {
                 gf_MagickRenderToFile(l, ss.str().c_str(), &view);
             }
             #endif
+
+            if(done)
+                break;
+        }
+
+        delete pool;
+
+        return iters;
+    }
+
+    /// Lays out a range of components, each on the calling thread
+    class ComponentTask : public RangeTask {
+        public:
+            ComponentTask(fr_options& opt, std::vector<Network*>& subs, const std::vector<uint64>& order, uint64 seed, std::vector<uint64>& iters)
+                : opt_(opt), subs_(subs), order_(order), seed_(seed), iters_(iters) {}
+
+            void run(uint64 begin, uint64 end) {
+                for(uint64 i=begin; i<end; ++i) {
+                    uint64 c = order_[i];
+                    fr_options opt(opt_);
+                    iters_[c] = FRLayout(opt, *subs_[c], NULL, NULL, Box(), frMix64(seed_ + c));
+                }
+            }
+
+        protected:
+            fr_options& opt_;
+            std::vector<Network*>& subs_;
+            const std::vector<uint64>& order_;
+            uint64 seed_;
+            std::vector<uint64>& iters_;
+    };
+
+    // components with the most elements first, so the pool stays busy
+    struct ComponentSizeOrder {
+        const std::vector<Network*>& subs;
+
+        ComponentSizeOrder(const std::vector<Network*>& s)
+            : subs(s) {}
+
+        bool operator()(uint64 a, uint64 b) const {
+            uint64 na = subs[a]->getTotalNumPts(), nb = subs[b]->getTotalNumPts();
+            return na > nb || (na == nb && a < b);
+        }
+    };
+
+    /** @brief Lay out each connected component separately and pack the results
+     * @details Every component is copied (by reference) into a temporary
+     * network and laid out on its own thread. Components containing locked
+     * elements stay where they are; the others are packed into rows to the
+     * right of them.
+     * @param[out] iters Largest number of iterations run for a component
+     * @return False if the network has fewer than two components
+     */
+    bool do_components(fr_options& opt, Network& net, uint64 seed, uint64& iters) {
+        int nsub = net.getNumSubgraphs();
+        if(nsub < 2)
+            return false;
+
+        // temporary networks; they do not own their elements
+        std::vector<Network*> subs;
+        for(int c=0; c<nsub; ++c)
+            subs.push_back(new Network());
+        for(Network::NodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i)
+            subs.at((*i)->getSubgraphIndex())->addNode(*i);
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            Reaction* r = *i;
+            if(r->isSetSubgraphIndex()) {
+                subs.at(r->getSubgraphIndex())->addReaction(r);
+            } else {
+                subs.push_back(new Network());
+                subs.back()->addReaction(r);
+            }
+        }
+
+        std::vector<uint64> order(subs.size());
+        for(uint64 c=0; c<subs.size(); ++c)
+            order[c] = c;
+        std::sort(order.begin(), order.end(), ComponentSizeOrder(subs));
+
+        // one thread per component; the pairwise & Barnes-Hut kernels are
+        // then free of rand() so the result does not depend on scheduling
+        fr_options copt(opt);
+        copt.components = 0;
+        copt.enable_comps = 0;
+        copt.parallel = 1;
+        copt.threads = 1;
+
+        std::vector<uint64> citers(subs.size(), 0);
+        {
+            ThreadPool pool(opt.threads > 0 ? (uint64)opt.threads : 0);
+            ComponentTask task(copt, subs, order, seed, citers);
+            pool.parallelFor(subs.size(), 1, task);
+        }
+        iters = *std::max_element(citers.begin(), citers.end());
+
+        // pack
+        std::vector<Box> boxes;
+        std::vector<uint64> movable;
+        Box fixed;
+        bool anyfixed = false;
+        for(uint64 c=0; c<subs.size(); ++c) {
+            Network* sub = subs[c];
+            Box b = sub->getElt(0)->getExtents();
+            bool locked = false;
+            for(uint64 i=0; i<sub->getNElts(); ++i) {
+                b.expandx(sub->getElt(i)->getExtents());
+                locked = locked || sub->getElt(i)->isLocked();
+            }
+            if(locked) {
+                if(anyfixed)
+                    fixed.expandx(b);
+                else
+                    fixed = b;
+                anyfixed = true;
+            } else {
+                boxes.push_back(b);
+                movable.push_back(c);
+            }
+        }
+
+        Real padding = opt.k;
+        Point origin(0,0);
+        if(anyfixed)
+            origin = Point(fixed.getMaxX() + padding, fixed.getMinY());
+
+        std::vector<Point> offsets;
+        packBoxes(boxes, padding, origin, offsets);
+        for(uint64 z=0; z<movable.size(); ++z) {
+            Network* sub = subs[movable[z]];
+            for(uint64 i=0; i<sub->getNElts(); ++i) {
+                NetworkElement* elt = sub->getElt(i);
+                elt->setCentroid(elt->getCentroid() + offsets[z]);
+            }
+        }
+
+        for(uint64 c=0; c<subs.size(); ++c)
+            delete subs[c];
+
+        return true;
+    }
+
+    /** @brief Pauses move tracking for the elements of a network
+     * @details The layout moves elements from worker threads, and component
+     * sub-networks report to the same indexing network, so recording each
+     * move would race. Tracking is paused on every indexing network for the
+     * lifetime of this object; @ref markAll then records all the elements at
+     * once on the calling thread.
+     */
+    class MoveTrackingPause {
+    public:
+        MoveTrackingPause(Network& net)
+          : net_(net) {
+            for(uint64 i=0; i<net_.getNElts(); ++i) {
+                Network* idx = net_.getElt(i)->getIndexingNetwork();
+                if(idx && std::find(paused_.begin(), paused_.end(), idx) == paused_.end()) {
+                    idx->pauseMoveTracking();
+                    paused_.push_back(idx);
+                }
+            }
+        }
+
+        ~MoveTrackingPause() {
+            resume();
+        }
+
+        /// Resume tracking and mark every element moved
+        void markAll() {
+            resume();
+            for(uint64 i=0; i<net_.getNElts(); ++i)
+                net_.getElt(i)->markMoved();
+        }
+
+    protected:
+        void resume() {
+            for(std::vector<Network*>::iterator i=paused_.begin(); i!=paused_.end(); ++i)
+                (*i)->resumeMoveTracking();
+            paused_.clear();
+        }
+
+        Network& net_;
+        std::vector<Network*> paused_;
+    };
+
+    /** @brief Returns @ref fr_options::random_seed and keeps the layout off rand()
+     * @details The serial pairwise path calls rand() directly, so the
+     * parallel mode's kernels are used on a single thread instead.
+     */
+    static uint64 useSeed(fr_options& opt) {
+        if(!opt.parallel) {
+            opt.parallel = 1;
+            opt.threads = 1;
+        }
+        return opt.random_seed;
+    }
+
+    uint64 FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l) {
+        //AT(feenableexcept(FE_DIVBYZERO) != -1);
+        Box bound;
+        if(opt.boundary) {
+            AN(can, "Boundary specified but no canvas");
+            bound = can->getBox();
+            if(bound.canShrink(20.))
+                bound.shrink_(20.);
+            if(opt.autobary) {
+                //adjust barycenter
+                opt.baryx = can->getWidth() *0.5;
+                opt.baryy = can->getHeight()*0.5;
+            }
         }
         
-        if(!opt.enable_comps)
+        // seed for the random numbers of the deterministic paths
+        uint64 seed = 0;
+        if(opt.random_seed)
+            seed = useSeed(opt);
+        else if(opt.parallel || opt.multilevel || opt.components || opt.repulsion != GF_REPULSION_EXACT)
+            seed = rand();
+
+        // a warm start keeps the current arrangement, so nothing may scramble it
+        if(opt.warmstart == GF_WARMSTART_ALWAYS || (opt.warmstart && net.isLayoutSpecified())) {
+            opt.multilevel = 0;
+            opt.components = 0;
+        } else
+            opt.warmstart = GF_WARMSTART_OFF;
+
+        uint64 iters;
+        bool split;
+        {
+            MoveTrackingPause pause(net);
+            split = opt.components && do_components(opt, net, seed, iters);
+            if(!split)
+                iters = FRLayout(opt, net, can, l, bound, seed);
+            pause.markAll();
+        }
+        
+        // compartment forces are not used when components are laid out separately
+        if(!opt.enable_comps || split)
             net.resizeCompsEnclose(opt.padding);
         
         net.rebuildCurves();
+
+        return iters;
+    }
+
+    uint64 FruchtermanReingoldCached(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l) {
+        std::shared_ptr<LayoutCache> cache = LayoutCache::getActive();
+        // keyed on the positions before they are randomized
+        uint64 key = 0;
+        if(cache) {
+            key = LayoutCache::computeKey(opt, net, can);
+            if(cache->lookup(key, net))
+                return 0;
+        }
+
+        if(opt.prerandomize)
+            //TODO: use canvas width, height
+            net.randomizePositions(Graphfab::Box(Graphfab::Point(0.,0.), Graphfab::Point(1024., 1024.)), opt.random_seed);
+
+        uint64 iters = FruchtermanReingold(opt, net, can, l);
+
+        if(cache)
+            cache->store(key, net, can);
+        return iters;
+    }
+
+    /** @brief Lay out the neighbourhood of a set of edited elements
+     * @details The region is every element within @a hops steps of
+     * @a changed in the bipartite species/reaction graph. It is copied (by
+     * reference) into a temporary network together with the reactions
+     * touching it and any element lying near it. Everything outside the
+     * region is locked for the duration of the pass, so it repels and
+     * attracts the region without moving.
+     */
+    uint64 FruchtermanReingoldIncremental(fr_options opt, Network& net, const std::vector<NetworkElement*>& changed, int hops) {
+        if(changed.empty())
+            return 0;
+
+        // breadth-first search out to the given depth
+        std::set<NetworkElement*> region;
+        std::vector<NetworkElement*> frontier;
+        for(std::vector<NetworkElement*>::const_iterator i=changed.begin(); i!=changed.end(); ++i) {
+            AN(*i, "No element");
+            if((*i)->getType() == NET_ELT_TYPE_COMP)
+                continue;
+            if(region.insert(*i).second)
+                frontier.push_back(*i);
+        }
+        for(int h=0; h<hops && !frontier.empty(); ++h) {
+            std::vector<NetworkElement*> next;
+            for(std::vector<NetworkElement*>::iterator i=frontier.begin(); i!=frontier.end(); ++i) {
+                if((*i)->getType() == NET_ELT_TYPE_RXN) {
+                    Reaction* r = (Reaction*)*i;
+                    for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j)
+                        if(region.insert(j->first).second)
+                            next.push_back(j->first);
+                } else {
+                    Network::AttachedRxnList rxns = net.getConnectedReactions((Node*)*i);
+                    for(Network::AttachedRxnList::iterator j=rxns.begin(); j!=rxns.end(); ++j)
+                        if(region.insert(*j).second)
+                            next.push_back(*j);
+                }
+            }
+            frontier.swap(next);
+        }
+        if(region.empty())
+            return 0;
+
+        // temporary network; it does not own its elements. The sets are only
+        // used for membership: elements are added in the order of @a net so
+        // the result does not depend on their addresses
+        Network sub;
+        std::set<NetworkElement*> taken;
+        std::vector<Reaction*> touched;
+        Box bound = (*region.begin())->getExtents();
+        for(std::set<NetworkElement*>::iterator i=region.begin(); i!=region.end(); ++i)
+            bound.expandx((*i)->getExtents());
+        for(Network::NodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i)
+            if(region.count(*i)) {
+                sub.addNode(*i);
+                taken.insert(*i);
+            }
+        // reactions which have a moving element and therefore need new curves
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i) {
+            Reaction* r = *i;
+            bool moves = region.count(r) != 0;
+            for(Reaction::NodeIt j=r->NodesBegin(); !moves && j!=r->NodesEnd(); ++j)
+                moves = region.count(j->first) != 0;
+            if(moves) {
+                sub.addReaction(r);
+                taken.insert(r);
+                touched.push_back(r);
+            }
+        }
+        // pinned elements near the region, which keep it from overlapping them
+        bound = bound.padded(4.*opt.k);
+        for(Network::NodeIt i=net.NodesBegin(); i!=net.NodesEnd(); ++i)
+            if(!taken.count(*i) && bound.contains((*i)->getCentroid())) {
+                sub.addNode(*i);
+                taken.insert(*i);
+            }
+        for(Network::RxnIt i=net.RxnsBegin(); i!=net.RxnsEnd(); ++i)
+            if(!taken.count(*i) && bound.contains((*i)->getCentroid())) {
+                sub.addReaction(*i);
+                taken.insert(*i);
+            }
+        // the (pinned) species of every reaction taken so far
+        for(Network::RxnIt i=sub.RxnsBegin(); i!=sub.RxnsEnd(); ++i)
+            for(Reaction::NodeIt j=(*i)->NodesBegin(); j!=(*i)->NodesEnd(); ++j)
+                if(taken.insert(j->first).second)
+                    sub.addNode(j->first);
+
+        std::vector<int> wasLocked(sub.getNElts());
+        for(uint64 i=0; i<sub.getNElts(); ++i) {
+            NetworkElement* elt = sub.getElt(i);
+            wasLocked[i] = elt->isLocked();
+            if(!region.count(elt))
+                elt->lock();
+        }
+
+        // short and cool: the rest of the layout is already settled
+        opt.multilevel = 0;
+        opt.components = 0;
+        opt.enable_comps = 0;
+        opt.prerandomize = 0;
+        if(opt.maxiter <= 0)
+            opt.maxiter = 50;
+
+        uint64 seed = opt.random_seed ? useSeed(opt) : rand();
+        uint64 iters;
+        {
+            MoveTrackingPause pause(sub);
+            iters = FRLayout(opt, sub, NULL, NULL, Box(), seed, 2.*opt.k);
+            pause.markAll();
+        }
+
+        for(uint64 i=0; i<sub.getNElts(); ++i) {
+            if(wasLocked[i])
+                sub.getElt(i)->lock();
+            else
+                sub.getElt(i)->unlock();
+        }
+
+        net.resizeCompsEnclose(opt.padding);
+
+        for(std::vector<Reaction*>::iterator i=touched.begin(); i!=touched.end(); ++i) {
+            (*i)->rebuildCurves();
+            (*i)->clipCurves();
+        }
+
+        return iters;
     }
 
 }
@@ -49,6 +49,41 @@
 extern "C" {
 #endif
 
+/**
+ *  @author JKM
+ *  @brief Method used to compute the repulsive forces
+ *  @sa fr_options
+ *  \ingroup C_API
+ */
+typedef enum {
+    /// Evaluate the repulsion between every pair of elements (quadratic in the number of elements)
+    GF_REPULSION_EXACT,
+    /// Approximate distant groups of elements using a Barnes-Hut quadtree (n log n)
+    GF_REPULSION_BARNES_HUT,
+    /**
+     * Only elements closer than @ref fr_options::cutoff repel, found with a
+     * uniform grid (linear for sparse networks); every
+     * @ref fr_options::correction iterations the full repulsion is applied
+     * (using Barnes-Hut) so distant parts of the network still push apart
+     */
+    GF_REPULSION_GRID
+} gf_repulsionMode;
+
+/**
+ *  @author JKM
+ *  @brief When to start from the existing coordinates
+ *  @sa fr_options
+ *  \ingroup C_API
+ */
+typedef enum {
+    /// Always start hot (the existing arrangement is not kept)
+    GF_WARMSTART_OFF,
+    /// Start warm if the network came with layout information (see @ref gf_nw_isLayoutSpecified)
+    GF_WARMSTART_IF_SPECIFIED,
+    /// Start warm from whatever the current coordinates are
+    GF_WARMSTART_ALWAYS
+} gf_warmStartMode;
+
   /**
  *  @author JKM
  *  @brief Options passed to the Fruchterman-Reingold algorithm
@@ -82,6 +117,85 @@ typedef struct __fr_options {
     int prerandomize;
     /// Padding on compartments
     Real padding;
+    /// How repulsive forces are computed (a @ref gf_repulsionMode)
+    int repulsion;
+    /**
+     * @brief Accuracy parameter for @ref GF_REPULSION_BARNES_HUT
+     * @details A cell of the quadtree is treated as a single body when its width
+     * divided by its distance is less than theta. Zero reproduces the exact
+     * computation; larger values are faster but less accurate.
+     */
+    Real theta;
+    /**
+     * @brief Compute forces on several threads?
+     * @details Parallel mode works on a structure-of-arrays copy of the
+     * network with a SIMD force kernel chosen at run time (see frkernel.h).
+     * Each element's repulsion is summed in a fixed
+     * order independent of how the work is divided, so the result is the same
+     * for any number of threads. Coincident elements are pushed apart by a
+     * kick derived from a hash of the pair rather than from rand().
+     */
+    int parallel;
+    /// Number of threads used in parallel mode (0 = one per hardware thread)
+    int threads;
+    /**
+     * @brief Use the multilevel scheme?
+     * @details The species/reaction graph is coarsened by matching connected
+     * elements, the coarsest graph is laid out, and the result is prolonged
+     * & refined level by level. The regular iterations then only refine the
+     * finest level, starting from a low temperature. Recommended for large
+     * networks; has no effect on networks too small to coarsen.
+     */
+    int multilevel;
+    /**
+     * @brief Convergence tolerance (0 = always run the full schedule)
+     * @details The layout stops early once no species or reaction moves more
+     * than tolerance*k in an iteration, or once the energy (total squared
+     * force) has changed by less than a fraction tolerance for 10 consecutive
+     * iterations.
+     */
+    Real tolerance;
+    /**
+     * @brief Use adaptive cooling?
+     * @details Instead of following a fixed exponential schedule, the
+     * temperature is lowered whenever the energy fails to decrease and raised
+     * slightly after five consecutive decreases. The layout stops when the
+     * temperature reaches the final temperature of the fixed schedule.
+     */
+    int adaptive;
+    /// Cap on the number of iterations (0 = none); the default schedule is 100*log(n+2) for n species & reactions
+    int maxiter;
+    /// Wall-clock budget in seconds (0 = unlimited); results are then not reproducible
+    Real maxtime;
+    /**
+     * @brief Lay out connected components separately?
+     * @details Each component is laid out on its own thread (up to
+     * @ref threads at once) using the parallel mode's kernels, and the
+     * results are packed into rows. Compartment forces are not used.
+     * Components containing locked elements are not moved.
+     */
+    int components;
+    /**
+     * @brief Refine the existing layout instead of starting hot (a @ref gf_warmStartMode)
+     * @details The initial temperature is taken from the forces acting on
+     * the current layout (the median displacement of the elements) and the
+     * number of iterations is cut down to match, so a layout that is
+     * already close to settled only gets a short, cool refinement. Disables
+     * @ref multilevel and @ref components, which would rearrange it.
+     */
+    int warmstart;
+    /// Range of the repulsion for @ref GF_REPULSION_GRID (0 = 4*k)
+    Real cutoff;
+    /// Iterations between full repulsion passes for @ref GF_REPULSION_GRID (0 = 10, negative = never)
+    int correction;
+    /**
+     * @brief Seed for the layout's random numbers (0 = draw one from rand())
+     * @details A nonzero seed makes the result independent of rand() and
+     * therefore of other threads: the serial mode then uses the parallel
+     * mode's kernels on a single thread, and @ref prerandomize draws from
+     * the seed too.
+     */
+    uint64_t random_seed;
 } fr_options;
 
 /**
@@ -90,18 +204,20 @@ typedef struct __fr_options {
  *  @note @ref l should be a layout info object obtained from a call to @ref gf_processLayout.
  *  @param[in] opt The options controlling the layout algorithm
  *  @param[in/out] l The layout info
+ *  @return The number of iterations run
  *  \ingroup C_API
  */
-_GraphfabExport void gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l);
+_GraphfabExport uint64_t gf_doLayoutAlgorithm(fr_options opt, gf_layoutInfo* l);
 
 /** @brief Run the autolayout (Fruchterman-Reingold) algorithm on a a network and optional canvas
  *  @details Can be used when full layout struct is not available
  *  @param[in] opt The options controlling the layout algorithm
  *  @param[in/out] n The network
  *  @param[in] c The canvas (may be NULL)
+ *  @return The number of iterations run
  *  \ingroup C_API
  */
-_GraphfabExport void gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c);
+_GraphfabExport uint64_t gf_doLayoutAlgorithm2(fr_options opt, gf_network* n, gf_canvas* c);
 
 /** @brief Generate default values for the layout options
  *  @param[out] l The layout info in which to store the options
@@ -116,6 +232,89 @@ _GraphfabExport void gf_getLayoutOptDefaults(fr_options* opt);
  */
 _GraphfabExport void gf_layout_setStiffness(fr_options* opt, double k);
 
+/** @brief Use the Barnes-Hut approximation for repulsive forces
+ *  @param[out] opt The layout options
+ *  @param[in] theta The accuracy parameter (0.8 is a reasonable choice)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setBarnesHut(fr_options* opt, double theta);
+
+/** @brief Only compute repulsion between nearby elements
+ *  @param[out] opt The layout options
+ *  @param[in] cutoff Range of the repulsion (0 = 4*k)
+ *  @param[in] correction Iterations between full repulsion passes (0 = 10, negative = never)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setGridRepulsion(fr_options* opt, double cutoff, int correction);
+
+/** @brief Compute forces on several threads
+ *  @param[out] opt The layout options
+ *  @param[in] threads The number of threads (0 = one per hardware thread)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setThreads(fr_options* opt, int threads);
+
+/** @brief Enable or disable the multilevel scheme
+ *  @param[out] opt The layout options
+ *  @param[in] multilevel Nonzero to enable
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setMultilevel(fr_options* opt, int multilevel);
+
+/** @brief Stop the layout early once it has converged
+ *  @param[out] opt The layout options
+ *  @param[in] tolerance The convergence tolerance (see @ref fr_options::tolerance)
+ *  @param[in] adaptive Nonzero to use adaptive cooling
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setConvergence(fr_options* opt, double tolerance, int adaptive);
+
+/** @brief Limit the work done by the layout
+ *  @param[out] opt The layout options
+ *  @param[in] maxiter Maximum number of iterations (0 = no cap); never lengthens the default schedule
+ *  @param[in] maxtime Wall-clock budget in seconds (0 = unlimited)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setBudget(fr_options* opt, int maxiter, double maxtime);
+
+/** @brief Lay out connected components separately and pack them
+ *  @param[out] opt The layout options
+ *  @param[in] components Nonzero to enable
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setComponents(fr_options* opt, int components);
+
+/** @brief Start from the existing coordinates
+ *  @param[out] opt The layout options
+ *  @param[in] warmstart A @ref gf_warmStartMode
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setWarmStart(fr_options* opt, int warmstart);
+
+/** @brief Make the layout reproducible
+ *  @param[out] opt The layout options
+ *  @param[in] seed Seed for the random numbers (0 = draw one from rand())
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_layout_setRandomSeed(fr_options* opt, uint64_t seed);
+
+/** @brief Re-run the layout around edited elements only
+ *  @details Elements more than @a hops steps (species to reaction or
+ *  reaction to species) away from the changed elements stay where they
+ *  are. The remaining elements get a short, cool FR pass against their
+ *  pinned neighbours, and only the curves touching them are rebuilt.
+ *  @param[in] opt The layout options (@ref fr_options::maxiter bounds the pass; 0 = 50 iterations)
+ *  @param[in,out] n The network
+ *  @param[in] nodes The changed nodes (may be NULL if @a nnodes is zero)
+ *  @param[in] nnodes The number of changed nodes
+ *  @param[in] rxns The changed reactions (may be NULL if @a nrxns is zero)
+ *  @param[in] nrxns The number of changed reactions
+ *  @param[in] hops Size of the neighbourhood that is allowed to move
+ *  @return The number of iterations run
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_doIncrementalLayout(fr_options opt, gf_network* n, gf_node** nodes, uint64_t nnodes, gf_reaction** rxns, uint64_t nrxns, int hops);
+
 #ifdef __cplusplus
 }//extern "C"
 #endif
@@ -126,11 +325,21 @@ _GraphfabExport void gf_layout_setStiffness(fr_options* opt, double k);
 // #include <string>
 
 #include <iostream>
+#include <vector>
 
 namespace Graphfab {
 
-    /// Software Practice & Experience '91
-    void FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l);
+    /// Software Practice & Experience '91; returns the number of iterations run (the most for any component)
+    uint64 FruchtermanReingold(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l);
+
+    /** @brief Applies @ref fr_options::prerandomize and runs @ref FruchtermanReingold,
+     * going through the layout cache if one is enabled (see @ref gf_enableLayoutCache)
+     * @return The number of iterations run (0 on a cache hit)
+     */
+    uint64 FruchtermanReingoldCached(fr_options opt, Network& net, Canvas* can, gf_layoutInfo* l);
+
+    /// Lay out only the @a hops neighbourhood of @a changed; returns the number of iterations run
+    uint64 FruchtermanReingoldIncremental(fr_options opt, Network& net, const std::vector<NetworkElement*>& changed, int hops);
     
 }
 
@@ -0,0 +1,322 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/frkernel.h"
+#include "graphfab/network/network.h"
+#include "graphfab/math/min_max.h"
+
+#include <map>
+#include <math.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define SBNW_FR_KERNEL_X86 1
+    #include <immintrin.h>
+#else
+    #define SBNW_FR_KERNEL_X86 0
+#endif
+
+namespace Graphfab {
+
+    FRKernelISA frKernelDetectISA() {
+        #if SBNW_FR_KERNEL_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx2"))
+            return FR_KERNEL_AVX2;
+        if(__builtin_cpu_supports("sse2"))
+            return FR_KERNEL_SSE2;
+        #endif
+        return FR_KERNEL_SCALAR;
+    }
+
+    static FRKernelISA& currentISA() {
+        static FRKernelISA isa = frKernelDetectISA();
+        return isa;
+    }
+
+    FRKernelISA frKernelGetISA() {
+        return currentISA();
+    }
+
+    void frKernelSetISA(FRKernelISA isa) {
+        FRKernelISA best = frKernelDetectISA();
+        currentISA() = isa < best ? isa : best;
+    }
+
+    const char* frKernelISAName(FRKernelISA isa) {
+        switch(isa) {
+            case FR_KERNEL_AVX2:
+                return "avx2";
+            case FR_KERNEL_SSE2:
+                return "sse2";
+            default:
+                return "scalar";
+        }
+    }
+
+    uint64 frMix64(uint64 x) {
+        x = (x ^ (x >> 30))*0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27))*0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    // uses the upper 53 bits
+    Real frHashToUnit(uint64 h) {
+        return (Real)(h >> 11)*(2./9007199254740992.) - 1.;
+    }
+
+    Point frCoincidentKick(uint64 salt, uint64 i, uint64 j, uint64 num) {
+        uint64 h = frMix64(salt ^ frMix64((i < j ? i : j)*0x9e3779b97f4a7c15ULL + (i < j ? j : i)));
+        Real extreme = 100.*sqrt((Real)num);
+        Point f(extreme*frHashToUnit(h), extreme*frHashToUnit(frMix64(h)));
+        return i < j ? f : -f;
+    }
+
+    //--CLASS FRBodies--
+
+    void FRBodies::build(Network& net) {
+        elts.clear();
+        deg.clear();
+        ideg.clear();
+        spec.clear();
+        eu.clear();
+        ev.clear();
+
+        std::map<const NetworkElement*, uint64> index;
+        int maxdeg = 0;
+        for(uint64 i=0; i<net.getNElts(); ++i) {
+            NetworkElement* u = net.getElt(i);
+            if(u->getType() == NET_ELT_TYPE_COMP)
+                continue;
+            index[u] = elts.size();
+            elts.push_back(u);
+            deg.push_back((Real)u->degree());
+            ideg.push_back((int)u->degree());
+            spec.push_back(u->getType() == NET_ELT_TYPE_SPEC);
+            if(ideg.back() > maxdeg)
+                maxdeg = ideg.back();
+        }
+
+        logdeg.resize(2*maxdeg+1);
+        for(int s=0; s<(int)logdeg.size(); ++s)
+            logdeg[s] = log((Real)s+2);
+
+        for(uint64 r=0; r<net.getTotalNumRxns(); ++r) {
+            Reaction* u = net.getRxnAt(r);
+            for(Reaction::NodeIt j=u->NodesBegin(); j!=u->NodesEnd(); ++j) {
+                AT(index.count(j->first), "Species not in network");
+                eu.push_back(index[u]);
+                ev.push_back(index[j->first]);
+            }
+        }
+
+        x.resize(elts.size());
+        y.resize(elts.size());
+        dim.resize(elts.size());
+        dvx.resize(elts.size());
+        dvy.resize(elts.size());
+    }
+
+    void FRBodies::gather(uint64 begin, uint64 end) {
+        for(uint64 i=begin; i<end; ++i) {
+            const NetworkElement* u = elts[i];
+            Point p = u->getCentroid();
+            x[i] = p.x;
+            y[i] = p.y;
+            dim[i] = max(u->getWidth(), u->getHeight());
+            dvx[i] = dvy[i] = 0.;
+        }
+    }
+
+    void FRBodies::scatter(uint64 begin, uint64 end) {
+        for(uint64 i=begin; i<end; ++i)
+            elts[i]->addDelta(Point(dvx[i], dvy[i]));
+    }
+
+    void FRBodies::getPositions(std::vector<Point>& p) const {
+        p.resize(size());
+        for(uint64 i=0; i<size(); ++i)
+            p[i] = pos(i);
+    }
+
+    //--Kernels--
+
+    // Every variant below performs, per pair, exactly these operations in
+    // this order (no fused multiply-add), matching the element-based code.
+
+    static inline void repulRowScalar(FRBodies& b, uint64 i, uint64 j0, uint64 j1, Real k, uint64 num, uint64 salt) {
+        Real fx = b.dvx[i], fy = b.dvy[i];
+        for(uint64 j=j0; j<j1; ++j) {
+            Real dx = b.x[i] - b.x[j];
+            Real dy = b.y[i] - b.y[j];
+            Real m2 = dx*dx + dy*dy;
+            if(m2 < 1e-6) {
+                if(j != i) {
+                    Point kick = frCoincidentKick(salt, i, j, num);
+                    fx += kick.x;
+                    fy += kick.y;
+                }
+                continue;
+            }
+            Real m = sqrt(m2);
+            Real d = max(m, 0.1);
+            Real adjk = k*b.logdeg[b.ideg[i] + b.ideg[j]] + (b.dim[i] + b.dim[j])*0.25;
+            Real s = adjk*adjk/d;
+            Real inv = 1./m;
+            fx += (dx*inv)*s;
+            fy += (dy*inv)*s;
+        }
+        b.dvx[i] = fx;
+        b.dvy[i] = fy;
+    }
+
+    // add the kicks for the coincident lanes of a row group
+    static void repulKicks(uint64 i, uint64 j, int mask, int lanes, uint64 num, uint64 salt, Real* fx, Real* fy) {
+        for(int l=0; l<lanes; ++l) {
+            if(!(mask & (1 << l)) || i+l == j)
+                continue;
+            Point kick = frCoincidentKick(salt, i+l, j, num);
+            fx[l] += kick.x;
+            fy[l] += kick.y;
+        }
+    }
+
+    #if SBNW_FR_KERNEL_X86
+    __attribute__((target("sse2")))
+    static void repulRowsSSE2(FRBodies& b, uint64 i, uint64 j0, uint64 j1, Real k, uint64 num, uint64 salt) {
+        const __m128d xi = _mm_loadu_pd(&b.x[i]), yi = _mm_loadu_pd(&b.y[i]), dimi = _mm_loadu_pd(&b.dim[i]);
+        const __m128d kk = _mm_set1_pd(k), quarter = _mm_set1_pd(0.25), one = _mm_set1_pd(1.);
+        const __m128d tenth = _mm_set1_pd(0.1), ep = _mm_set1_pd(1e-6);
+        const int deg0 = b.ideg[i], deg1 = b.ideg[i+1];
+        __m128d fx = _mm_loadu_pd(&b.dvx[i]), fy = _mm_loadu_pd(&b.dvy[i]);
+
+        for(uint64 j=j0; j<j1; ++j) {
+            __m128d dx = _mm_sub_pd(xi, _mm_set1_pd(b.x[j]));
+            __m128d dy = _mm_sub_pd(yi, _mm_set1_pd(b.y[j]));
+            __m128d m2 = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            __m128d near = _mm_cmplt_pd(m2, ep);
+            __m128d m = _mm_sqrt_pd(m2);
+            __m128d d = _mm_max_pd(m, tenth);
+            __m128d lg = _mm_set_pd(b.logdeg[deg1 + b.ideg[j]], b.logdeg[deg0 + b.ideg[j]]);
+            __m128d adjk = _mm_add_pd(_mm_mul_pd(kk, lg), _mm_mul_pd(_mm_add_pd(dimi, _mm_set1_pd(b.dim[j])), quarter));
+            __m128d s = _mm_div_pd(_mm_mul_pd(adjk, adjk), d);
+            __m128d inv = _mm_div_pd(one, m);
+            fx = _mm_add_pd(fx, _mm_andnot_pd(near, _mm_mul_pd(_mm_mul_pd(dx, inv), s)));
+            fy = _mm_add_pd(fy, _mm_andnot_pd(near, _mm_mul_pd(_mm_mul_pd(dy, inv), s)));
+
+            int mask = _mm_movemask_pd(near);
+            if(mask) {
+                Real ax[2], ay[2];
+                _mm_storeu_pd(ax, fx);
+                _mm_storeu_pd(ay, fy);
+                repulKicks(i, j, mask, 2, num, salt, ax, ay);
+                fx = _mm_loadu_pd(ax);
+                fy = _mm_loadu_pd(ay);
+            }
+        }
+
+        _mm_storeu_pd(&b.dvx[i], fx);
+        _mm_storeu_pd(&b.dvy[i], fy);
+    }
+
+    __attribute__((target("avx2")))
+    static void repulRowsAVX2(FRBodies& b, uint64 i, uint64 j0, uint64 j1, Real k, uint64 num, uint64 salt) {
+        const __m256d xi = _mm256_loadu_pd(&b.x[i]), yi = _mm256_loadu_pd(&b.y[i]), dimi = _mm256_loadu_pd(&b.dim[i]);
+        const __m256d kk = _mm256_set1_pd(k), quarter = _mm256_set1_pd(0.25), one = _mm256_set1_pd(1.);
+        const __m256d tenth = _mm256_set1_pd(0.1), ep = _mm256_set1_pd(1e-6);
+        const __m128i degi = _mm_loadu_si128((const __m128i*)&b.ideg[i]);
+        const double* logdeg = &b.logdeg[0];
+        __m256d fx = _mm256_loadu_pd(&b.dvx[i]), fy = _mm256_loadu_pd(&b.dvy[i]);
+
+        for(uint64 j=j0; j<j1; ++j) {
+            __m256d dx = _mm256_sub_pd(xi, _mm256_set1_pd(b.x[j]));
+            __m256d dy = _mm256_sub_pd(yi, _mm256_set1_pd(b.y[j]));
+            __m256d m2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            __m256d near = _mm256_cmp_pd(m2, ep, _CMP_LT_OQ);
+            __m256d m = _mm256_sqrt_pd(m2);
+            __m256d d = _mm256_max_pd(m, tenth);
+            __m256d lg = _mm256_i32gather_pd(logdeg, _mm_add_epi32(degi, _mm_set1_epi32(b.ideg[j])), 8);
+            __m256d adjk = _mm256_add_pd(_mm256_mul_pd(kk, lg), _mm256_mul_pd(_mm256_add_pd(dimi, _mm256_set1_pd(b.dim[j])), quarter));
+            __m256d s = _mm256_div_pd(_mm256_mul_pd(adjk, adjk), d);
+            __m256d inv = _mm256_div_pd(one, m);
+            fx = _mm256_add_pd(fx, _mm256_andnot_pd(near, _mm256_mul_pd(_mm256_mul_pd(dx, inv), s)));
+            fy = _mm256_add_pd(fy, _mm256_andnot_pd(near, _mm256_mul_pd(_mm256_mul_pd(dy, inv), s)));
+
+            int mask = _mm256_movemask_pd(near);
+            if(mask) {
+                Real ax[4], ay[4];
+                _mm256_storeu_pd(ax, fx);
+                _mm256_storeu_pd(ay, fy);
+                repulKicks(i, j, mask, 4, num, salt, ax, ay);
+                fx = _mm256_loadu_pd(ax);
+                fy = _mm256_loadu_pd(ay);
+            }
+        }
+
+        _mm256_storeu_pd(&b.dvx[i], fx);
+        _mm256_storeu_pd(&b.dvy[i], fy);
+    }
+    #endif
+
+    void frRepulsionBlock(FRBodies& b, uint64 i0, uint64 i1, uint64 j0, uint64 j1, Real k, uint64 num, uint64 salt) {
+        uint64 i = i0;
+        #if SBNW_FR_KERNEL_X86
+        FRKernelISA isa = frKernelGetISA();
+        if(isa >= FR_KERNEL_AVX2)
+            for(; i+4 <= i1; i += 4)
+                repulRowsAVX2(b, i, j0, j1, k, num, salt);
+        if(isa >= FR_KERNEL_SSE2)
+            for(; i+2 <= i1; i += 2)
+                repulRowsSSE2(b, i, j0, j1, k, num, salt);
+        #endif
+        for(; i<i1; ++i)
+            repulRowScalar(b, i, j0, j1, k, num, salt);
+    }
+
+    void frAttractionEdges(const FRBodies& b, uint64 e0, uint64 e1, Real k, Point* fu, Point* fv, char* active) {
+        for(uint64 e=e0; e<e1; ++e) {
+            uint64 u = b.eu[e], v = b.ev[e];
+            Point disp(b.x[u] - b.x[v], b.y[u] - b.y[v]);
+            Point delta(disp.normed());
+            Real d = disp.mag();
+
+            active[e] = d > 1.e-6;
+            if(!active[e])
+                continue;
+
+            Real adjk = (k*b.logdeg[b.ideg[u] + b.ideg[v]] + (b.dim[v] + b.dim[u])/4);
+            Real ku = b.spec[u] ? adjk : k, kv = b.spec[v] ? adjk : k;
+            fu[e] = -delta * (d*d/ku);
+            fv[e] =  delta * (d*d/kv);
+        }
+    }
+
+}
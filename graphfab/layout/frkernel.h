@@ -0,0 +1,158 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file frkernel.h
+ * @brief Structure-of-arrays force kernels for the layout algorithm
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_FRKERNEL_H_
+#define __SBNW_LAYOUT_FRKERNEL_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/point.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace Graphfab {
+
+    class NetworkElement;
+    class Network;
+
+    /// Instruction set used by the force kernels
+    enum FRKernelISA {
+        /// Plain C++
+        FR_KERNEL_SCALAR,
+        /// Two lanes of doubles
+        FR_KERNEL_SSE2,
+        /// Four lanes of doubles
+        FR_KERNEL_AVX2
+    };
+
+    /// Best instruction set supported by the CPU (detected once)
+    FRKernelISA frKernelDetectISA();
+
+    /// Instruction set the kernels currently use (defaults to @ref frKernelDetectISA)
+    FRKernelISA frKernelGetISA();
+
+    /// Override the instruction set (clamped to what the CPU supports)
+    void frKernelSetISA(FRKernelISA isa);
+
+    /// Name of an instruction set for diagnostics
+    const char* frKernelISAName(FRKernelISA isa);
+
+    /// Mix the bits of @a x (SplitMix64 finalizer); used to derive reproducible random numbers
+    uint64 frMix64(uint64 x);
+
+    /// Map a hash to [-1, 1)
+    Real frHashToUnit(uint64 h);
+
+    /** @brief Kick given to a pair of (nearly) coincident elements
+     * @details Stands in for the random force used by the serial layout.
+     * The kick is derived from a hash of the pair instead of rand() so that
+     * it does not depend on the order in which pairs are visited. The kick
+     * on j due to i is the negation of the kick on i due to j.
+     * @param[in] salt Derived once per iteration from a seed drawn with rand()
+     */
+    Point frCoincidentKick(uint64 salt, uint64 i, uint64 j, uint64 num);
+
+    /** @brief Species & reactions of a network as contiguous arrays
+     * @details The topology (degrees, sizes, edges) is copied once per layout
+     * by @ref build; only the centroids and sizes are refreshed each iteration by
+     * @ref gather. Forces are accumulated in @ref dvx / @ref dvy and written
+     * back to the elements by @ref scatter just before they move.
+     * Compartments are not included.
+     */
+    class FRBodies {
+        public:
+            /// Copy the species & reactions of @a net
+            void build(Network& net);
+
+            /// Refresh the centroids & sizes of bodies [begin, end) and clear their forces
+            void gather(uint64 begin, uint64 end);
+
+            /// Add the accumulated forces of bodies [begin, end) to the elements
+            void scatter(uint64 begin, uint64 end);
+
+            /// Number of bodies
+            uint64 size() const { return elts.size(); }
+
+            /// Centroid of a body
+            Point pos(uint64 i) const { return Point(x[i], y[i]); }
+
+            /// Centroids as points (for @ref BHTree)
+            void getPositions(std::vector<Point>& p) const;
+
+            std::vector<NetworkElement*> elts;
+            /// Centroids
+            std::vector<Real> x, y;
+            /// Degrees
+            std::vector<Real> deg;
+            /// Degrees as integers (index into @ref logdeg)
+            std::vector<int> ideg;
+            /// Sizes (max of width & height)
+            std::vector<Real> dim;
+            /// True for species
+            std::vector<char> spec;
+            /// log(s+2) for every possible sum s of two degrees
+            std::vector<Real> logdeg;
+            /// Reaction end of each edge, in the order of the network's reactions
+            std::vector<uint64> eu;
+            /// Species end of each edge
+            std::vector<uint64> ev;
+            /// Accumulated forces
+            std::vector<Real> dvx, dvy;
+    };
+
+    /** @brief Pairwise repulsion on a block of bodies
+     * @details Adds the repulsion on rows [i0, i1) due to columns [j0, j1)
+     * to @ref FRBodies::dvx / @ref FRBodies::dvy. Several rows are processed
+     * at once in SIMD lanes; each row still sums its columns in ascending
+     * order with the same operations as the scalar code, so the result is
+     * identical for every instruction set.
+     */
+    void frRepulsionBlock(FRBodies& b, uint64 i0, uint64 i1, uint64 j0, uint64 j1, Real k, uint64 num, uint64 salt);
+
+    /** @brief Attraction along edges [e0, e1)
+     * @details Stores the force on the reaction end in @a fu and on the
+     * species end in @a fv; @a active is cleared for coincident ends.
+     */
+    void frAttractionEdges(const FRBodies& b, uint64 e0, uint64 e1, Real k, Point* fu, Point* fv, char* active);
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,527 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/layoutcache.h"
+#include "graphfab/layout/frkernel.h"
+#include "graphfab/interface/snapshot.h"
+#include "graphfab/util/mappedfile.h"
+#include "graphfab/diag/error.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <dirent.h>
+    #include <unistd.h>
+#else
+    #include <windows.h>
+    #include <direct.h>
+    #include <process.h>
+#endif
+
+namespace Graphfab {
+
+    static const char* const layoutCacheExt = ".snap";
+
+    /// File in a directory listing
+    struct CacheDirEntry {
+        std::string name;
+        uint64 bytes;
+        /// Modification time (only the order matters)
+        uint64 mtime;
+    };
+
+    static bool makeCacheDir(const std::string& dir) {
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+        struct stat st;
+        if(!stat(dir.c_str(), &st))
+            return S_ISDIR(st.st_mode);
+        return !mkdir(dir.c_str(), 0777);
+#else
+        DWORD a = GetFileAttributesA(dir.c_str());
+        if(a != INVALID_FILE_ATTRIBUTES)
+            return (a & FILE_ATTRIBUTE_DIRECTORY) != 0;
+        return !_mkdir(dir.c_str());
+#endif
+    }
+
+    static std::vector<CacheDirEntry> listCacheDir(const std::string& dir) {
+        std::vector<CacheDirEntry> files;
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+        DIR* d = opendir(dir.c_str());
+        if(!d)
+            return files;
+        while(struct dirent* e = readdir(d)) {
+            CacheDirEntry f;
+            f.name = e->d_name;
+            struct stat st;
+            if(stat((dir + "/" + f.name).c_str(), &st) || !S_ISREG(st.st_mode))
+                continue;
+            f.bytes = (uint64)st.st_size;
+            f.mtime = (uint64)st.st_mtime;
+            files.push_back(f);
+        }
+        closedir(d);
+#else
+        WIN32_FIND_DATAA fd;
+        HANDLE h = FindFirstFileA((dir + "\\*").c_str(), &fd);
+        if(h == INVALID_HANDLE_VALUE)
+            return files;
+        do {
+            if(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+                continue;
+            CacheDirEntry f;
+            f.name = fd.cFileName;
+            f.bytes = ((uint64)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+            f.mtime = ((uint64)fd.ftLastWriteTime.dwHighDateTime << 32) | fd.ftLastWriteTime.dwLowDateTime;
+            files.push_back(f);
+        } while(FindNextFileA(h, &fd));
+        FindClose(h);
+#endif
+        return files;
+    }
+
+    static unsigned long cacheProcessId() {
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+        return (unsigned long)getpid();
+#else
+        return (unsigned long)_getpid();
+#endif
+    }
+
+    /// Parse "<16 hex digits>.snap"
+    static bool parseCacheName(const std::string& name, uint64& key) {
+        if(name.size() != 16 + strlen(layoutCacheExt) || name.compare(16, std::string::npos, layoutCacheExt))
+            return false;
+        key = 0;
+        for(int k=0; k<16; ++k) {
+            char c = name[k];
+            uint64 d;
+            if(c >= '0' && c <= '9')
+                d = c - '0';
+            else if(c >= 'a' && c <= 'f')
+                d = c - 'a' + 10;
+            else
+                return false;
+            key = (key << 4) | d;
+        }
+        return true;
+    }
+
+    //--CLASS LayoutKeyHasher--
+
+    /// 64-bit FNV-1a over the fields fed to it
+    class LayoutKeyHasher {
+        public:
+            LayoutKeyHasher() : h_(14695981039346656037ULL) {}
+
+            void add(const void* data, size_t n) {
+                const unsigned char* p = (const unsigned char*)data;
+                for(size_t k=0; k<n; ++k) {
+                    h_ ^= p[k];
+                    h_ *= 1099511628211ULL;
+                }
+            }
+
+            void add(uint64 x) { add(&x, sizeof(x)); }
+
+            void add(int x) { add((uint64)(int64)x); }
+
+            void addReal(Real x) {
+                double d = x;
+                add(&d, sizeof(d));
+            }
+
+            void addPoint(const Point& p) { addReal(p.x); addReal(p.y); }
+
+            void addStr(const std::string& s) {
+                add((uint64)s.size());
+                add(s.data(), s.size());
+            }
+
+            uint64 get() const { return frMix64(h_); }
+
+        protected:
+            uint64 h_;
+    };
+
+    //--CLASS LayoutCache--
+
+    static std::mutex activeCacheMutex;
+    static std::shared_ptr<LayoutCache> activeCache;
+
+    LayoutCache::LayoutCache(const std::string& dir, const gf_layoutCacheOptions& opt)
+      : dir_(dir), opt_(opt), clock_(0), tmpcount_(0) {
+        memset(&stats_, 0, sizeof(stats_));
+        if(!makeCacheDir(dir_))
+            SBNW_THROW(FileWriteFailureException, "Unable to create the layout cache directory", "LayoutCache::LayoutCache");
+        scan();
+    }
+
+    uint64 LayoutCache::computeKey(const fr_options& opt, Network& net, const Canvas* can) {
+        LayoutKeyHasher h;
+        h.addStr("sbnw layout cache");
+        h.add((uint64)SNAPSHOT_VERSION);
+
+        // every option except the thread count, which does not change the result
+        h.addReal(opt.k);
+        h.add(opt.boundary);
+        h.add(opt.mag);
+        h.addReal(opt.grav);
+        h.addReal(opt.baryx);
+        h.addReal(opt.baryy);
+        h.add(opt.autobary);
+        h.add(opt.enable_comps);
+        h.add(opt.prerandomize);
+        h.addReal(opt.padding);
+        h.add(opt.repulsion);
+        h.addReal(opt.theta);
+        h.add(opt.parallel);
+        h.add(opt.multilevel);
+        h.addReal(opt.tolerance);
+        h.add(opt.adaptive);
+        h.add(opt.maxiter);
+        h.addReal(opt.maxtime);
+        h.add(opt.components);
+        h.add(opt.warmstart);
+        h.addReal(opt.cutoff);
+        h.add(opt.correction);
+        // only when set, so that existing keys stay valid
+        if(opt.random_seed)
+            h.add((uint64)opt.random_seed);
+
+        h.addReal(can ? can->getWidth() : 0.);
+        h.addReal(can ? can->getHeight() : 0.);
+
+        // the starting positions only matter if the layout starts from them
+        const bool pos = !opt.prerandomize &&
+            (net.isLayoutSpecified() || opt.warmstart == GF_WARMSTART_ALWAYS);
+        h.add((uint64)pos);
+
+        std::unordered_map<const NetworkElement*, uint64> compIdx, nodeIdx;
+
+        h.add((uint64)net.getTotalNumComps());
+        for(uint64 i=0; i<net.getTotalNumComps(); ++i) {
+            Compartment* c = net.getCompAt(i);
+            compIdx[c] = i;
+            h.addStr(c->getId());
+            h.add((uint64)c->isLocked());
+            Box b = c->getLocalExtents();
+            if(pos || c->isLocked()) {
+                h.addPoint(b.getMin());
+                h.addPoint(b.getMax());
+            } else
+                h.addPoint(b.getDiag());
+        }
+
+        h.add((uint64)net.getTotalNumNodes());
+        for(uint64 i=0; i<net.getTotalNumNodes(); ++i) {
+            Node* n = net.getNodeAt(i);
+            nodeIdx[n] = i;
+            h.addStr(n->getId());
+            h.add((uint64)n->numUses());
+            h.add((uint64)n->isAlias());
+            h.add(n->_comp && compIdx.count(n->_comp) ? compIdx[n->_comp] + 1 : (uint64)0);
+            h.addPoint(n->getLocalExtents().getDiag());
+            h.add((uint64)n->isLocked());
+            if(pos || n->isLocked())
+                h.addPoint(n->_p);
+        }
+
+        h.add((uint64)net.getTotalNumRxns());
+        for(uint64 i=0; i<net.getTotalNumRxns(); ++i) {
+            Reaction* r = net.getRxnAt(i);
+            h.addStr(r->getId());
+            h.add((uint64)r->numSpecies());
+            for(Reaction::ConstNodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                h.add(nodeIdx.count(j->first) ? nodeIdx[j->first] : (uint64)-1);
+                h.add((uint64)j->second);
+            }
+            h.add((uint64)r->isLocked());
+            if(pos || r->isLocked())
+                h.addPoint(r->_p);
+        }
+
+        return h.get();
+    }
+
+    bool LayoutCache::lookup(uint64 key, Network& net) {
+        Network* cached = NULL;
+        Canvas* canv = NULL;
+        uint64 bytes = 0;
+        try {
+            MappedFile file(pathFor(key).c_str());
+            int level, version;
+            cached = readSnapshot(file.getData(), file.getSize(), &canv, &level, &version);
+            bytes = file.getSize();
+        } catch(const Exception&) {
+            // missing, or removed / corrupted by another process
+        }
+        delete canv;
+
+        // guard against hash collisions
+        bool match = cached &&
+            cached->getTotalNumNodes() == net.getTotalNumNodes() &&
+            cached->getTotalNumRxns() == net.getTotalNumRxns() &&
+            cached->getTotalNumComps() == net.getTotalNumComps();
+        for(uint64 i=0; match && i<net.getTotalNumNodes(); ++i)
+            match = cached->getNodeAt(i)->getId() == net.getNodeAt(i)->getId();
+        for(uint64 i=0; match && i<net.getTotalNumRxns(); ++i)
+            match = cached->getRxnAt(i)->getId() == net.getRxnAt(i)->getId() &&
+                cached->getRxnAt(i)->numSpecies() == net.getRxnAt(i)->numSpecies();
+        for(uint64 i=0; match && i<net.getTotalNumComps(); ++i)
+            match = cached->getCompAt(i)->getId() == net.getCompAt(i)->getId();
+
+        if(match) {
+            for(uint64 i=0; i<net.getTotalNumComps(); ++i) {
+                Compartment* src = cached->getCompAt(i);
+                Compartment* dst = net.getCompAt(i);
+                dst->setRestExtents(src->getLocalExtents());
+                dst->recalcExtents();
+                dst->setRestArea(src->restArea());
+            }
+            for(uint64 i=0; i<net.getTotalNumNodes(); ++i) {
+                Node* src = cached->getNodeAt(i);
+                Node* dst = net.getNodeAt(i);
+                dst->setExtents(src->getLocalExtents());
+                dst->_p = src->_p;
+                dst->setCentroidSetFlag(true);
+            }
+            for(uint64 i=0; i<net.getTotalNumRxns(); ++i)
+                net.getRxnAt(i)->setCentroid(cached->getRxnAt(i)->_p);
+            net.rebuildCurves();
+        }
+
+        if(cached) {
+            cached->hierarchRelease();
+            delete cached;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(match) {
+            ++stats_.hits;
+            touch(key, bytes, false);
+        } else
+            ++stats_.misses;
+        return match;
+    }
+
+    void LayoutCache::store(uint64 key, Network& net, const Canvas* can) {
+        std::string data;
+        std::string path = pathFor(key), tmp;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            char buf[64];
+            sprintf(buf, ".%lu.%llu.tmp", cacheProcessId(), (unsigned long long)tmpcount_++);
+            tmp = path + buf;
+        }
+
+        try {
+            writeSnapshot(data, net, can, 0, 0);
+        } catch(const Exception& e) {
+            gf_setError(("LayoutCache: unable to store layout: " + e.getReport()).c_str());
+            return;
+        }
+
+        // write then rename, so readers never see a partial entry
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if(!f) {
+            gf_setError("LayoutCache: unable to create cache entry");
+            return;
+        }
+        size_t written = fwrite(data.data(), 1, data.size(), f);
+        if(fclose(f) || written != data.size()) {
+            remove(tmp.c_str());
+            gf_setError("LayoutCache: unable to write cache entry");
+            return;
+        }
+#if SAGITTARIUS_PLATFORM == SAGITTARIUS_PLATFORM_WIN
+        remove(path.c_str());
+#endif
+        if(rename(tmp.c_str(), path.c_str())) {
+            remove(tmp.c_str());
+            gf_setError("LayoutCache: unable to write cache entry");
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++stats_.stores;
+        touch(key, data.size(), true);
+        evict();
+    }
+
+    void LayoutCache::clear() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while(!entries_.empty())
+            removeEntry(entries_.begin());
+    }
+
+    gf_layoutCacheStats LayoutCache::getStats() const {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    std::shared_ptr<LayoutCache> LayoutCache::getActive() {
+        std::unique_lock<std::mutex> lock(activeCacheMutex);
+        return activeCache;
+    }
+
+    void LayoutCache::setActive(const std::shared_ptr<LayoutCache>& cache) {
+        std::unique_lock<std::mutex> lock(activeCacheMutex);
+        activeCache = cache;
+    }
+
+    std::string LayoutCache::pathFor(uint64 key) const {
+        char name[32];
+        sprintf(name, "%016llx", (unsigned long long)key);
+        return dir_ + "/" + name + layoutCacheExt;
+    }
+
+    void LayoutCache::scan() {
+        std::vector<CacheDirEntry> files = listCacheDir(dir_);
+        std::vector< std::pair<uint64, std::pair<uint64, uint64> > > found; // mtime, key, bytes
+        for(std::vector<CacheDirEntry>::const_iterator i=files.begin(); i!=files.end(); ++i) {
+            uint64 key;
+            if(parseCacheName(i->name, key))
+                found.push_back(std::make_pair(i->mtime, std::make_pair(key, i->bytes)));
+        }
+        // oldest first, so that age order is kept for both policies
+        std::sort(found.begin(), found.end());
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(size_t k=0; k<found.size(); ++k)
+            touch(found[k].second.first, found[k].second.second, true);
+        evict();
+    }
+
+    void LayoutCache::touch(uint64 key, uint64 bytes, bool created) {
+        EntryMap::iterator i = entries_.find(key);
+        if(i == entries_.end()) {
+            Entry e;
+            e.bytes = bytes;
+            e.created = e.used = ++clock_;
+            entries_.insert(std::make_pair(key, e));
+            ++stats_.entries;
+            stats_.bytes += bytes;
+            return;
+        }
+        // replaced by this or another process
+        stats_.bytes += bytes;
+        stats_.bytes -= i->second.bytes;
+        i->second.bytes = bytes;
+        i->second.used = ++clock_;
+        if(created)
+            i->second.created = clock_;
+    }
+
+    void LayoutCache::evict() {
+        while(!entries_.empty() &&
+              ((opt_.max_entries && stats_.entries > opt_.max_entries) ||
+               (opt_.max_bytes && stats_.bytes > opt_.max_bytes))) {
+            EntryMap::iterator victim = entries_.begin();
+            for(EntryMap::iterator i=entries_.begin(); i!=entries_.end(); ++i) {
+                if(opt_.eviction == GF_CACHE_EVICT_FIFO ?
+                     i->second.created < victim->second.created :
+                     i->second.used < victim->second.used)
+                    victim = i;
+            }
+            removeEntry(victim);
+            ++stats_.evictions;
+        }
+    }
+
+    void LayoutCache::removeEntry(EntryMap::iterator i) {
+        remove(pathFor(i->first).c_str());
+        --stats_.entries;
+        stats_.bytes -= i->second.bytes;
+        entries_.erase(i);
+    }
+
+}
+
+using namespace Graphfab;
+
+void gf_getLayoutCacheOptDefaults(gf_layoutCacheOptions* opt) {
+    opt->max_entries = 0;
+    opt->max_bytes = 256*1024*1024;
+    opt->eviction = GF_CACHE_EVICT_LRU;
+}
+
+int gf_enableLayoutCache(const char* dir, const gf_layoutCacheOptions* opt) {
+    if(!dir || !*dir) {
+        gf_setError("gf_enableLayoutCache: no directory");
+        return -1;
+    }
+    gf_layoutCacheOptions o;
+    if(opt)
+        o = *opt;
+    else
+        gf_getLayoutCacheOptDefaults(&o);
+
+    try {
+        LayoutCache::setActive(std::make_shared<LayoutCache>(dir, o));
+    } catch(const Exception& e) {
+        gf_setError(e.getReport().c_str());
+        return -1;
+    }
+    return 0;
+}
+
+void gf_disableLayoutCache() {
+    LayoutCache::setActive(std::shared_ptr<LayoutCache>());
+}
+
+void gf_clearLayoutCache() {
+    std::shared_ptr<LayoutCache> cache = LayoutCache::getActive();
+    if(cache)
+        cache->clear();
+}
+
+void gf_getLayoutCacheStats(gf_layoutCacheStats* stats) {
+    std::shared_ptr<LayoutCache> cache = LayoutCache::getActive();
+    if(cache)
+        *stats = cache->getStats();
+    else
+        memset(stats, 0, sizeof(*stats));
+}
+
+uint64_t gf_layoutCacheKey(fr_options opt, gf_layoutInfo* l) {
+    Network* net = (Network*)l->net;
+    AN(net, "No network");
+    return LayoutCache::computeKey(opt, *net, (Canvas*)l->canv);
+}
@@ -0,0 +1,222 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file layoutcache.h
+ * @brief On-disk cache of finished layouts
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_LAYOUTCACHE_H_
+#define __SBNW_LAYOUT_LAYOUTCACHE_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/fr.h"
+
+#include <stdint.h>
+
+//-- C code --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  @brief Which entry the layout cache removes when it is full
+ *  @sa gf_layoutCacheOptions
+ *  \ingroup C_API
+ */
+typedef enum {
+    /// Remove the entry which was used least recently
+    GF_CACHE_EVICT_LRU,
+    /// Remove the entry which was stored first
+    GF_CACHE_EVICT_FIFO
+} gf_cacheEviction;
+
+/**
+ *  @brief Options for @ref gf_enableLayoutCache
+ *  @sa gf_getLayoutCacheOptDefaults
+ *  \ingroup C_API
+ */
+typedef struct {
+    /// Maximum number of entries (0 = no limit)
+    uint64_t max_entries;
+    /// Maximum combined size of the entries in bytes (0 = no limit)
+    uint64_t max_bytes;
+    /// Eviction policy (a @ref gf_cacheEviction)
+    int eviction;
+} gf_layoutCacheOptions;
+
+/**
+ *  @brief Counters for the layout cache
+ *  \ingroup C_API
+ */
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    /// Layouts written to the cache
+    uint64_t stores;
+    /// Entries removed to stay within the limits
+    uint64_t evictions;
+    /// Current number of entries
+    uint64_t entries;
+    /// Current combined size of the entries in bytes
+    uint64_t bytes;
+} gf_layoutCacheStats;
+
+/** @brief Fill @a opt with the defaults: at most 256 MB, least recently used evicted first
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_getLayoutCacheOptDefaults(gf_layoutCacheOptions* opt);
+
+/**
+ *  @brief Cache the results of @ref gf_doLayoutAlgorithm in a directory
+ *  @details Each entry is a snapshot (see @ref gf_saveSnapshot) named
+ *  after a hash of the network's structure and the layout options (see
+ *  @ref gf_layoutCacheKey). When @ref gf_doLayoutAlgorithm or
+ *  @ref gf_doLayoutAlgorithm2 is called for a network whose key is
+ *  cached, the cached coordinates are copied onto the network and no
+ *  iterations are run. Entries already in @a dir are picked up, so the
+ *  directory can be reused across runs and shared between processes.
+ *  The directory is created if it does not exist. Replaces any cache
+ *  which was enabled before.
+ *  @param[in] opt May be NULL for the defaults
+ *  @return 0 on success; otherwise sets the last error
+ *  \ingroup C_API
+ */
+_GraphfabExport int gf_enableLayoutCache(const char* dir, const gf_layoutCacheOptions* opt);
+
+/** @brief Stop using the layout cache (the entries stay on disk)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_disableLayoutCache();
+
+/** @brief Remove every entry of the layout cache
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_clearLayoutCache();
+
+/** @brief Get the counters of the layout cache (all zero if it is not enabled)
+ *  \ingroup C_API
+ */
+_GraphfabExport void gf_getLayoutCacheStats(gf_layoutCacheStats* stats);
+
+/**
+ *  @brief Key under which the layout of @a l with @a opt is cached
+ *  @details Hashes the species (ids, sizes, compartments and aliasing),
+ *  the reactions and the roles of their species, the compartments, the
+ *  canvas size and every option which affects the result. The
+ *  positions of locked elements are included. The starting positions
+ *  of the other elements are only included if the layout
+ *  would start from them, i.e. if the model came with a layout or a
+ *  warm start was forced, and @ref fr_options::prerandomize is not set.
+ *  \ingroup C_API
+ */
+_GraphfabExport uint64_t gf_layoutCacheKey(fr_options opt, gf_layoutInfo* l);
+
+#ifdef __cplusplus
+}
+#endif
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <string>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+namespace Graphfab {
+
+    /** @brief Directory of finished layouts keyed by @ref computeKey
+     * @details Safe to use from several threads. Errors while reading
+     * or writing entries are treated as misses.
+     */
+    class LayoutCache {
+        public:
+            /// Scans @a dir for existing entries and evicts down to the limits
+            LayoutCache(const std::string& dir, const gf_layoutCacheOptions& opt);
+
+            /// See @ref gf_layoutCacheKey
+            static uint64 computeKey(const fr_options& opt, Network& net, const Canvas* can);
+
+            /// Copy the cached layout for @a key onto @a net; false on a miss
+            bool lookup(uint64 key, Network& net);
+
+            /// Save the layout of @a net under @a key; failures are reported with @ref gf_setError and are otherwise ignored
+            void store(uint64 key, Network& net, const Canvas* can);
+
+            /// Remove every entry
+            void clear();
+
+            gf_layoutCacheStats getStats() const;
+
+            /// The cache used by @ref gf_doLayoutAlgorithm (NULL if disabled)
+            static std::shared_ptr<LayoutCache> getActive();
+
+            static void setActive(const std::shared_ptr<LayoutCache>& cache);
+
+        protected:
+            struct Entry {
+                uint64 bytes;
+                /// Clock value when stored
+                uint64 created;
+                /// Clock value when last stored or hit
+                uint64 used;
+            };
+            typedef std::unordered_map<uint64, Entry> EntryMap;
+
+            std::string pathFor(uint64 key) const;
+
+            void scan();
+
+            /// Add or refresh an entry; call with @ref mutex_ held
+            void touch(uint64 key, uint64 bytes, bool created);
+
+            /// Remove entries until within the limits; call with @ref mutex_ held
+            void evict();
+
+            void removeEntry(EntryMap::iterator i);
+
+            std::string dir_;
+            gf_layoutCacheOptions opt_;
+            mutable std::mutex mutex_;
+            EntryMap entries_;
+            uint64 clock_;
+            uint64 tmpcount_;
+            gf_layoutCacheStats stats_;
+    };
+
+}
+
+#endif
+
+#endif
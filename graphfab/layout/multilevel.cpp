@@ -0,0 +1,310 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/multilevel.h"
+#include "graphfab/layout/bhtree.h"
+#include "graphfab/network/network.h"
+#include "graphfab/math/min_max.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace Graphfab {
+
+    // adjacency entry used while building a level
+    struct FRLevelEdge {
+        uint64 u, v;
+        Real w;
+
+        FRLevelEdge(uint64 u_, uint64 v_, Real w_)
+            : u(u_), v(v_), w(w_) {}
+
+        bool operator<(const FRLevelEdge& o) const {
+            return u < o.u || (u == o.u && v < o.v);
+        }
+    };
+
+    // merge duplicate entries & store in compressed form
+    static void buildAdjacency(uint64 n, std::vector<FRLevelEdge>& edges, FRLevel& g) {
+        std::sort(edges.begin(), edges.end());
+
+        g.adjstart.assign(n+1, 0);
+        g.adj.clear();
+        g.adjw.clear();
+        for(uint64 e=0; e<edges.size(); ++e) {
+            if(e && edges[e].u == edges[e-1].u && edges[e].v == edges[e-1].v) {
+                g.adjw.back() += edges[e].w;
+                continue;
+            }
+            g.adj.push_back(edges[e].v);
+            g.adjw.push_back(edges[e].w);
+            ++g.adjstart[edges[e].u+1];
+        }
+        for(uint64 u=0; u<n; ++u)
+            g.adjstart[u+1] += g.adjstart[u];
+    }
+
+    // used to visit the lightest vertices first
+    struct FRLevelWeightOrder {
+        const std::vector<Real>& w;
+
+        FRLevelWeightOrder(const std::vector<Real>& w_)
+            : w(w_) {}
+
+        bool operator()(uint64 a, uint64 b) const {
+            return w[a] < w[b] || (w[a] == w[b] && a < b);
+        }
+    };
+
+    //--CLASS MultilevelLayout--
+
+    void MultilevelLayout::coarsen(const FRBodies& b, Real k) {
+        k_ = k;
+        levels_.clear();
+        levels_.push_back(FRLevel());
+
+        FRLevel& g = levels_.back();
+        const uint64 n = b.size();
+        g.pos.resize(n);
+        g.weight.assign(n, 1.);
+        g.scale.assign(n, 1.);
+        g.locked.resize(n);
+        for(uint64 i=0; i<n; ++i) {
+            g.pos[i] = b.pos(i);
+            g.locked[i] = b.elts[i]->isLocked();
+        }
+
+        std::vector<FRLevelEdge> edges;
+        for(uint64 e=0; e<b.eu.size(); ++e) {
+            edges.push_back(FRLevelEdge(b.eu[e], b.ev[e], 1.));
+            edges.push_back(FRLevelEdge(b.ev[e], b.eu[e], 1.));
+        }
+        buildAdjacency(n, edges, g);
+
+        while(levels_.size() < maxlevels_ && levels_.back().size() > mincoarse_) {
+            FRLevel coarse;
+            if(!coarsenLevel(levels_.back(), coarse))
+                break;
+            levels_.push_back(coarse);
+        }
+    }
+
+    bool MultilevelLayout::coarsenLevel(FRLevel& fine, FRLevel& coarse) {
+        const uint64 n = fine.size();
+        const uint64 none = (uint64)-1;
+
+        std::vector<uint64> order(n);
+        for(uint64 u=0; u<n; ++u)
+            order[u] = u;
+        std::sort(order.begin(), order.end(), FRLevelWeightOrder(fine.weight));
+
+        // heavy-edge matching; leaves whose only neighbour is taken join its group
+        fine.parent.assign(n, none);
+        uint64 nc = 0;
+        for(uint64 z=0; z<n; ++z) {
+            uint64 u = order[z];
+            if(fine.parent[u] != none)
+                continue;
+
+            uint64 best = none;
+            Real bestscore = 0.;
+            for(uint64 e=fine.adjstart[u]; e<fine.adjstart[u+1]; ++e) {
+                uint64 v = fine.adj[e];
+                if(v == u || fine.parent[v] != none)
+                    continue;
+                Real score = fine.adjw[e]/(fine.weight[u]*fine.weight[v]);
+                if(score > bestscore) {
+                    best = v;
+                    bestscore = score;
+                }
+            }
+
+            if(best != none) {
+                fine.parent[u] = fine.parent[best] = nc++;
+            } else if(fine.adjstart[u+1] - fine.adjstart[u] == 1) {
+                fine.parent[u] = fine.parent[fine.adj[fine.adjstart[u]]];
+            } else {
+                fine.parent[u] = nc++;
+            }
+        }
+
+        if(nc > 0.85*n) {
+            fine.parent.clear();
+            return false;
+        }
+
+        coarse.pos.assign(nc, Point(0,0));
+        coarse.weight.assign(nc, 0.);
+        coarse.scale.resize(nc);
+        coarse.locked.assign(nc, 0);
+        for(uint64 u=0; u<n; ++u) {
+            uint64 c = fine.parent[u];
+            coarse.pos[c] += fine.weight[u]*fine.pos[u];
+            coarse.weight[c] += fine.weight[u];
+            if(fine.locked[u])
+                coarse.locked[c] = 1;
+        }
+        for(uint64 c=0; c<nc; ++c) {
+            coarse.pos[c] = coarse.pos[c]*(1./coarse.weight[c]);
+            coarse.scale[c] = sqrt(coarse.weight[c]);
+        }
+
+        std::vector<FRLevelEdge> edges;
+        for(uint64 u=0; u<n; ++u)
+            for(uint64 e=fine.adjstart[u]; e<fine.adjstart[u+1]; ++e)
+                if(fine.parent[u] != fine.parent[fine.adj[e]])
+                    edges.push_back(FRLevelEdge(fine.parent[u], fine.parent[fine.adj[e]], fine.adjw[e]));
+        buildAdjacency(nc, edges, coarse);
+
+        return true;
+    }
+
+    FRLevel& MultilevelLayout::getLevel(uint64 l) {
+        AT(l < levels_.size(), "No such level");
+        return levels_.at(l);
+    }
+
+    Real MultilevelLayout::getSpringLength(uint64 l) const {
+        const FRLevel& g = levels_.at(l);
+        Real w = 0.;
+        for(uint64 i=0; i<g.size(); ++i)
+            w += g.weight[i];
+        return g.size() ? k_*sqrt(w/g.size()) : k_;
+    }
+
+    void MultilevelLayout::layoutLevel(uint64 l, uint64 iters, Real Ti) {
+        FRLevel& g = getLevel(l);
+        const uint64 n = g.size();
+        if(n < 2 || !iters)
+            return;
+
+        const Real theta = 0.8;
+        std::vector<Point> f(n);
+        std::vector<Real> nodim(n, 0.);
+        std::vector<int> stack;
+        BHTree tree;
+
+        // cool by a factor of 100
+        Real alpha = log(100.);
+        Real t = 0., dt = 1./iters;
+
+        for(uint64 z=0; z<iters; ++z) {
+            Real T = Ti*exp(-alpha*t);
+            t += dt;
+
+            // the tree's degree slot carries the vertex scale
+            tree.build(g.pos, g.scale, nodim);
+            uint64 salt = frMix64(seed_ ^ frMix64(l*0x10000 + z));
+
+            for(uint64 i=0; i<n; ++i) {
+                const Point p = g.pos[i];
+                Point fi(0,0);
+
+                // repulsion
+                stack.clear();
+                stack.push_back(0);
+                while(!stack.empty()) {
+                    const BHTree::Cell& c = tree.getCell(stack.back());
+                    stack.pop_back();
+
+                    Point disp;
+                    Real s, count;
+                    if(c.leaf) {
+                        for(int j=c.first; j>=0; j=tree.getNextInLeaf(j)) {
+                            if(j == (int)i)
+                                continue;
+                            disp = p - g.pos[j];
+                            if(disp.mag2() < 1e-6) {
+                                fi += frCoincidentKick(salt, i, j, n);
+                                continue;
+                            }
+                            Real d = max(disp.mag(), 0.1);
+                            Real kk = k_*0.5*(g.scale[i] + g.scale[j]);
+                            fi += disp.normed()*(kk*kk/d);
+                        }
+                        continue;
+                    }
+
+                    disp = p - c.com;
+                    bool inside = fabs(p.x - c.center.x) <= c.half && fabs(p.y - c.center.y) <= c.half;
+                    if(inside || 2.*c.half >= theta*disp.mag()) {
+                        for(int q=0; q<4; ++q)
+                            if(c.child[q] >= 0)
+                                stack.push_back(c.child[q]);
+                        continue;
+                    }
+                    s = c.deg/c.count;
+                    count = c.count;
+                    Real d = max(disp.mag(), 0.1);
+                    Real kk = k_*0.5*(g.scale[i] + s);
+                    fi += disp.normed()*(count*kk*kk/d);
+                }
+
+                // attraction
+                for(uint64 e=g.adjstart[i]; e<g.adjstart[i+1]; ++e) {
+                    uint64 j = g.adj[e];
+                    Point disp = g.pos[j] - p;
+                    Real d = disp.mag();
+                    if(d < 1e-6)
+                        continue;
+                    Real kk = k_*0.5*(g.scale[i] + g.scale[j]);
+                    fi += disp.normed()*(g.adjw[e]*d*d/kk);
+                }
+
+                // gravity
+                if(grav_ > 0.)
+                    fi += -(p - bary_)*(g.weight[i]*grav_/k_);
+
+                f[i] = fi;
+            }
+
+            for(uint64 i=0; i<n; ++i)
+                if(!g.locked[i])
+                    g.pos[i] += f[i].capMag(T);
+        }
+    }
+
+    void MultilevelLayout::prolong(uint64 l) {
+        AT(l > 0, "Cannot prolong the finest level");
+        FRLevel& coarse = getLevel(l);
+        FRLevel& fine = getLevel(l-1);
+        Real spread = 0.25*getSpringLength(l-1);
+
+        for(uint64 u=0; u<fine.size(); ++u) {
+            if(fine.locked[u])
+                continue;
+            uint64 h = frMix64(seed_ ^ frMix64((l << 40) + u));
+            fine.pos[u] = coarse.pos[fine.parent[u]] + spread*Point(frHashToUnit(h), frHashToUnit(frMix64(h)));
+        }
+    }
+
+}
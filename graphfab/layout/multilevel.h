@@ -0,0 +1,141 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file multilevel.h
+ * @brief Coarsening hierarchy for the multilevel layout
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_MULTILEVEL_H_
+#define __SBNW_LAYOUT_MULTILEVEL_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/point.h"
+#include "graphfab/layout/frkernel.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief One level of the coarsening hierarchy
+     * @details Level 0 is the species/reaction graph itself; each vertex of
+     * a coarser level stands for a group of vertices of the level below.
+     */
+    struct FRLevel {
+        /// Number of vertices
+        uint64 size() const { return pos.size(); }
+
+        /// Positions
+        std::vector<Point> pos;
+        /// Number of species & reactions each vertex stands for
+        std::vector<Real> weight;
+        /// Square root of the weight (scales the natural spring length)
+        std::vector<Real> scale;
+        /// True if the vertex contains a locked element (it is not moved)
+        std::vector<char> locked;
+        /// Neighbours of v are adj[adjstart[v]] .. adj[adjstart[v+1]-1]
+        std::vector<uint64> adjstart, adj;
+        /// Weight of each adjacency (number of finer edges merged into it)
+        std::vector<Real> adjw;
+        /// Vertex of the next coarser level containing this one
+        std::vector<uint64> parent;
+    };
+
+    /** @brief Multilevel (coarsen, lay out, refine) scheme
+     * @details The graph is coarsened by heavy-edge matching; unmatched
+     * vertices with a single neighbour are then collapsed into it. Coarse
+     * levels are laid out with Fruchterman-Reingold forces scaled by vertex
+     * weight, using a Barnes-Hut quadtree for the repulsion. Each level's
+     * result is prolonged to the level below as its starting point.
+     */
+    class MultilevelLayout {
+        public:
+            MultilevelLayout()
+                : mincoarse_(20), maxlevels_(30), k_(50.), grav_(0.), bary_(0.,0.), seed_(0) {}
+
+            /** @brief Build the hierarchy
+             * @param[in] b The species & reactions (centroids must be gathered)
+             * @param[in] k Natural spring length at level 0
+             */
+            void coarsen(const FRBodies& b, Real k);
+
+            /// Number of levels (including level 0)
+            uint64 getNumLevels() const { return levels_.size(); }
+
+            /// Get a level
+            FRLevel& getLevel(uint64 l);
+
+            /** @brief Lay out a level
+             * @param[in] l     The level
+             * @param[in] iters Number of iterations
+             * @param[in] Ti    Initial temperature (maximum step); cooled by a factor of 100
+             */
+            void layoutLevel(uint64 l, uint64 iters, Real Ti);
+
+            /// Place the vertices of level l-1 around their parents in level l
+            void prolong(uint64 l);
+
+            /// Natural spring length of a level (grows with the mean vertex weight)
+            Real getSpringLength(uint64 l) const;
+
+            /// Stop coarsening at this many vertices
+            void setMinCoarseSize(uint64 n) { mincoarse_ = n; }
+
+            /// Maximum number of levels
+            void setMaxLevels(uint64 n) { maxlevels_ = n; }
+
+            /// Seed for the random numbers used by the layout & prolongation
+            void setSeed(uint64 seed) { seed_ = seed; }
+
+            /// Pull each vertex towards @a bary with the given strength (as in fr_options::grav), scaled by its weight
+            void setGravity(Real strength, const Point& bary) { grav_ = strength; bary_ = bary; }
+
+        protected:
+            /// Returns false if the matching did not shrink the graph enough
+            bool coarsenLevel(FRLevel& fine, FRLevel& coarse);
+
+            std::vector<FRLevel> levels_;
+            uint64 mincoarse_, maxlevels_;
+            Real k_;
+            Real grav_;
+            Point bary_;
+            uint64 seed_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/pack.h"
+#include "graphfab/math/min_max.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace Graphfab {
+
+    // tallest first, ties broken by index so the packing is reproducible
+    struct PackHeightOrder {
+        const std::vector<Box>& boxes;
+
+        PackHeightOrder(const std::vector<Box>& b)
+            : boxes(b) {}
+
+        bool operator()(uint64 a, uint64 b) const {
+            Real ha = boxes[a].height(), hb = boxes[b].height();
+            return ha > hb || (ha == hb && a < b);
+        }
+    };
+
+    void packBoxes(const std::vector<Box>& boxes, Real padding, const Point& origin, std::vector<Point>& offsets) {
+        const uint64 n = boxes.size();
+        offsets.assign(n, Point(0,0));
+        if(!n)
+            return;
+
+        Real area = 0., widest = 0.;
+        std::vector<uint64> order(n);
+        for(uint64 i=0; i<n; ++i) {
+            order[i] = i;
+            area += (boxes[i].width() + padding)*(boxes[i].height() + padding);
+            widest = max(widest, boxes[i].width() + padding);
+        }
+        std::sort(order.begin(), order.end(), PackHeightOrder(boxes));
+
+        Real rowwidth = max(sqrt(area), widest);
+        Real x = 0., y = 0., rowheight = 0.;
+        for(uint64 z=0; z<n; ++z) {
+            const Box& b = boxes[order[z]];
+            Real w = b.width() + padding, h = b.height() + padding;
+            if(x > 0. && x + w > rowwidth) {
+                // start a new row
+                y += rowheight;
+                x = 0.;
+                rowheight = 0.;
+            }
+            offsets[order[z]] = origin + Point(x, y) - b.getMin();
+            x += w;
+            rowheight = max(rowheight, h);
+        }
+    }
+
+}
@@ -0,0 +1,67 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file pack.h
+ * @brief Rectangle packing
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_PACK_H_
+#define __SBNW_LAYOUT_PACK_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/box.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief Pack boxes into rows (shelf packing)
+     * @details The boxes are placed tallest first, left to right, starting a
+     * new row whenever the current one would become wider than the square
+     * root of the total area (or the widest box). The result is roughly
+     * square with its upper left-hand corner at @a origin.
+     * @param[in]  boxes   The boxes to pack
+     * @param[in]  padding Space to leave between boxes
+     * @param[in]  origin  Upper left-hand corner of the packing
+     * @param[out] offsets Displacement to apply to each box
+     */
+    void packBoxes(const std::vector<Box>& boxes, Real padding, const Point& origin, std::vector<Point>& offsets);
+
+}
+
+#endif
+
+#endif
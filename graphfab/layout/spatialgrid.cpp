@@ -0,0 +1,104 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/spatialgrid.h"
+
+#include <math.h>
+
+namespace Graphfab {
+
+    //--CLASS SpatialGrid--
+
+    void SpatialGrid::build(const std::vector<Point>& pos, Real cell) {
+        AT(cell > 0., "Cell size must be positive");
+        cell_ = cell;
+
+        // about two buckets per point
+        uint64 nbuckets = 16;
+        while(nbuckets < 2*pos.size())
+            nbuckets <<= 1;
+        mask_ = nbuckets - 1;
+
+        cx_.resize(pos.size());
+        cy_.resize(pos.size());
+        start_.assign(nbuckets+1, 0);
+
+        std::vector<uint64> bucket(pos.size());
+        for(uint64 j=0; j<pos.size(); ++j) {
+            cx_[j] = cellOf(pos[j].x);
+            cy_[j] = cellOf(pos[j].y);
+            bucket[j] = bucketOf(cx_[j], cy_[j]);
+            ++start_[bucket[j]+1];
+        }
+
+        // counting sort, stable so each bucket is in ascending order
+        for(uint64 q=0; q<nbuckets; ++q)
+            start_[q+1] += start_[q];
+        std::vector<uint64> fill(start_.begin(), start_.end()-1);
+        items_.resize(pos.size());
+        for(uint64 j=0; j<pos.size(); ++j)
+            items_[fill[bucket[j]]++] = (int)j;
+
+        // buckets shared by several cells only make this an overestimate
+        Real sum = 0.;
+        for(uint64 q=0; q<nbuckets; ++q) {
+            Real c = (Real)(start_[q+1] - start_[q]);
+            sum += c*c;
+        }
+        occupancy_ = pos.size() ? sum/pos.size() : 0.;
+    }
+
+    void SpatialGrid::getNeighbours(const Point& p, std::vector<int>& out) const {
+        int64 px = cellOf(p.x), py = cellOf(p.y);
+        for(int64 cy=py-1; cy<=py+1; ++cy) {
+            for(int64 cx=px-1; cx<=px+1; ++cx) {
+                uint64 q = bucketOf(cx, cy);
+                for(uint64 z=start_[q]; z<start_[q+1]; ++z) {
+                    int j = items_[z];
+                    // other cells may share the bucket
+                    if(cx_[j] == cx && cy_[j] == cy)
+                        out.push_back(j);
+                }
+            }
+        }
+    }
+
+    int64 SpatialGrid::cellOf(Real x) const {
+        return (int64)floor(x/cell_);
+    }
+
+    uint64 SpatialGrid::bucketOf(int64 cx, int64 cy) const {
+        uint64 h = (uint64)cx*0x9E3779B97F4A7C15ULL ^ (uint64)cy*0xC2B2AE3D27D4EB4FULL;
+        return (h ^ (h >> 29)) & mask_;
+    }
+
+}
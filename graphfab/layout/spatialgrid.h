@@ -0,0 +1,109 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file spatialgrid.h
+ * @brief Uniform grid used to find nearby elements in the layout algorithm
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_LAYOUT_SPATIALGRID_H_
+#define __SBNW_LAYOUT_SPATIALGRID_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/point.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace Graphfab {
+
+    /** @brief Uniform grid of square cells
+     * @details Bins points into cells of a fixed width. Only occupied cells
+     * are stored: cells are hashed into a table of buckets, which is sized
+     * from the number of points rather than the extent of the layout, so
+     * widely spread layouts cost no more than compact ones. Points are
+     * referred to by their index in the input array.
+     */
+    class SpatialGrid {
+        public:
+            SpatialGrid()
+                : cell_(1.), mask_(0), occupancy_(0.) {}
+
+            /** @brief Build the grid
+             * @param[in] pos Point positions
+             * @param[in] cell Width of a cell
+             */
+            void build(const std::vector<Point>& pos, Real cell);
+
+            /// Width of a cell
+            Real getCellSize() const { return cell_; }
+
+            /**
+             * @brief Mean number of points in the cell of a point
+             * @details Proportional to the work done by @ref getNeighbours
+             * per point; large values mean the cells are too big for the
+             * spacing of the points.
+             */
+            Real getOccupancy() const { return occupancy_; }
+
+            /** @brief Get the points in the 3x3 block of cells around @a p
+             * @details Appends to @a out (which is not cleared). Any point
+             * within one cell width of @a p is included. The order is
+             * deterministic: cell by cell, ascending index within a cell.
+             */
+            void getNeighbours(const Point& p, std::vector<int>& out) const;
+
+        protected:
+            /// Cell containing a coordinate
+            int64 cellOf(Real x) const;
+
+            /// Bucket holding cell (cx, cy)
+            uint64 bucketOf(int64 cx, int64 cy) const;
+
+            Real cell_;
+            uint64 mask_;
+            Real occupancy_;
+            /// Points sorted by bucket
+            std::vector<int> items_;
+            /// Start of each bucket in @ref items_ (one extra entry at the end)
+            std::vector<uint64> start_;
+            /// Cell coordinates of each point
+            std::vector<int64> cx_, cy_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -32,6 +32,9 @@
 #include "graphfab/core/SagittariusCore.h"
 #include "graphfab/math/cubic.h"
 
+#include <cmath>
+#include <algorithm>
+
 namespace Graphfab {
     
     // CLASS CubicRoots:
@@ -104,6 +107,33 @@ namespace Graphfab {
         return std::polar(r, pi);
     }
 
+    int CubicRoots::getRealRoots(Real a2, Real a1, Real a0, Real* x) {
+      // depressed cubic t^3 + p*t + q with x = t - a2/3
+      Real shift = a2/3.;
+      Real p = a1 - a2*shift;
+      Real q = (2.*shift*shift - a1)*shift + a0;
+
+      Real h = q*q/4. + p*p*p/27.;
+      if (h > 0.) {
+        // one real root (Cardano)
+        Real s = std::sqrt(h);
+        x[0] = std::cbrt(-q/2. + s) + std::cbrt(-q/2. - s) - shift;
+        return 1;
+      } else if (p == 0.) {
+        // triple root
+        x[0] = -shift;
+        return 1;
+      } else {
+        // three real roots (trigonometric form)
+        Real m = 2.*std::sqrt(-p/3.);
+        Real c = 3.*q/(p*m);
+        Real theta = std::acos(std::max((Real)-1., std::min((Real)1., c)))/3.;
+        for (int k = 0; k<3; ++k)
+          x[k] = m*std::cos(theta - 2.*pi*k/3.) - shift;
+        return 3;
+      }
+    }
+
     std::ostream& operator<<(std::ostream& o, const CubicRoots& c) {
       o << c.getRoot(0) << ", " << c.getRoot(1) << ", " << c.getRoot(2);
       return o;
@@ -69,6 +69,14 @@ namespace Graphfab {
             /// Cubic root according to ZWH convention
             static Complex curtConventional(Complex x);
 
+            /** @brief Real roots of x^3 + a2*x^2 + a1*x + a0 = 0 using only real arithmetic
+             * @details Much cheaper than constructing a @ref CubicRoots object when
+             * the complex roots are not needed. Repeated roots are reported once.
+             * @param[out] x Room for three values
+             * @return The number of real roots
+             */
+            static int getRealRoots(Real a2, Real a1, Real a0, Real* x);
+
         protected:
           Complex x1_, x2_, x3_;
     };
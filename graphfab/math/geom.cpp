@@ -33,6 +33,8 @@
 #include "graphfab/math/geom.h"
 #include "graphfab/math/cubic.h"
 
+#include <algorithm>
+
 namespace Graphfab {
 
     Point calcCurveBackup(const Point& src, const Point& cent, const Box& ext, Real dist) {
@@ -78,6 +80,14 @@ namespace Graphfab {
     
     // CLASS Line2Desc:
     
+    void new2ndPos(const Point* first, const Point* second, uint64 n, const Real deg, const Real dist, const bool rel_dist, Point* result) {
+      const Real x = deg2r(deg);
+      const Real cr = (deg == 0.) ? 1. : cos(x);
+      const Real sr = (deg == 0.) ? 0. : sin(x);
+      for (uint64 i=0; i<n; ++i)
+        result[i] = new2ndPosRot(first[i], second[i], cr, sr, dist, rel_dist);
+    }
+
     Line2Desc::Line2Desc(const Point& start, const Point& end) {
       A_ = end.y - start.y;
       B_ = start.x - end.x;
@@ -99,8 +109,6 @@ namespace Graphfab {
     }
 
     Point CubicBezier2Desc::p(Real t) const {
-      if (t < 0. || t > 1.)
-        std::cerr << "Warning: t is out of bounds\n";
       Real u = 1.-t;
       return P0_*u*u*u + 3*u*u*t*P1_ + 3*u*t*t*P2_ + t*t*t*P3_;
     }
@@ -140,27 +148,167 @@ namespace Graphfab {
       Point gamma = -3*P0 + 3*P1;
       Point delta = P0;
 
-      // compare representations
-      std::cerr <<  "  CubicBezierIntersection: original: " << c.p(0) << ", " << c.p(0.5) << ", " << c.p(1) << "\n";
-      std::cerr <<  "  CubicBezierIntersection: modified: " << computeCubic(alpha, beta, gamma, delta, 0.)
-        << ", " << computeCubic(alpha, beta, gamma, delta, 0.5)
-        << ", " << computeCubic(alpha, beta, gamma, delta, 1.) << "\n";
-
       Real a2 = (A*beta.x + B*beta.y) / (A*alpha.x + B*alpha.y);
       Real a1 = (A*gamma.x + B*gamma.y) / (A*alpha.x + B*alpha.y);
       Real a0 = (C + A*delta.x + B*delta.y) / (A*alpha.x + B*alpha.y);
 
-      CubicRoots r(a2, a1, a0);
+      Real x[3];
+      int n = CubicRoots::getRealRoots(a2, a1, a0, x);
+
+      r_.assign(x, x+n);
+    }
+
+    // a*t^3 + b*t^2 + c*t + d
+    static Real evalCubic(Real a, Real b, Real c, Real d, Real t) {
+      return ((a*t + b)*t + c)*t + d;
+    }
+
+    int solveCubicInRange(Real a, Real b, Real c, Real d, Real tmin, Real tmax, Real* roots) {
+      Real scale = std::max(std::max(std::abs(a), std::abs(b)), std::max(std::abs(c), std::abs(d)));
+      if (scale == 0.)
+        return 0;
+      const Real ep = 1e-9*scale;
+
+      Real cand[3];
+      int n = 0;
+      if (std::abs(a) > ep) {
+        n = CubicRoots::getRealRoots(b/a, c/a, d/a, cand);
+      } else if (std::abs(b) > ep) {
+        Real disc = c*c - 4.*b*d;
+        if (disc >= 0.) {
+          // avoid cancellation
+          Real q = -0.5*(c + (c < 0. ? -1. : 1.)*std::sqrt(disc));
+          cand[n++] = q/b;
+          if (q != 0.)
+            cand[n++] = d/q;
+        }
+      } else if (std::abs(c) > ep) {
+        cand[n++] = -d/c;
+      }
+
+      // polish & filter
+      const Real tol = 1e-9;
+      int m = 0;
+      for (int i = 0; i<n; ++i) {
+        Real t = cand[i];
+        for (int k = 0; k<2; ++k) {
+          Real df = (3.*a*t + 2.*b)*t + c;
+          if (df == 0.)
+            break;
+          t -= evalCubic(a, b, c, d, t)/df;
+        }
+        if (!(t >= tmin - tol && t <= tmax + tol))
+          continue;
+        t = std::min(std::max(t, tmin), tmax);
+        if (std::abs(evalCubic(a, b, c, d, t)) > 1e-6*scale)
+          continue;
+        // drop duplicates
+        bool dup = false;
+        for (int j = 0; j<m; ++j)
+          if (std::abs(roots[j] - t) < tol)
+            dup = true;
+        if (!dup)
+          roots[m++] = t;
+      }
+      std::sort(roots, roots+m);
+      return m;
+    }
+
+    // CLASS CubicBezierBoxIntersection:
+
+    uint64 intersectCubicBeziersWithLines(const CubicBezier2Desc* curves, uint64 ncurves,
+                                          const Line2Desc* lines, uint64 nlines,
+                                          Real* roots, int* counts) {
+      uint64 total = 0;
+      for (uint64 i=0; i<ncurves; ++i) {
+        const Point P0 = curves[i].getCP(0);
+        const Point P1 = curves[i].getCP(1);
+        const Point P2 = curves[i].getCP(2);
+        const Point P3 = curves[i].getCP(3);
+        // power basis
+        const Real ax = -P0.x + 3.*P1.x - 3.*P2.x + P3.x, ay = -P0.y + 3.*P1.y - 3.*P2.y + P3.y;
+        const Real bx = 3.*P0.x - 6.*P1.x + 3.*P2.x,      by = 3.*P0.y - 6.*P1.y + 3.*P2.y;
+        const Real cx = 3.*(P1.x - P0.x),                 cy = 3.*(P1.y - P0.y);
+
+        for (uint64 j=0; j<nlines; ++j) {
+          const Line2Desc& l = lines[j];
+          const uint64 k = i*nlines + j;
+          // A*x(t) + B*y(t) + C = 0
+          counts[k] = solveCubicInRange(
+            l.getA()*ax + l.getB()*ay,
+            l.getA()*bx + l.getB()*by,
+            l.getA()*cx + l.getB()*cy,
+            l.getA()*P0.x + l.getB()*P0.y + l.getC(),
+            0., 1., roots + 3*k);
+          total += counts[k];
+        }
+      }
+      return total;
+    }
 
-      std::cerr << "CubicBezierIntersection: Got roots\n";
+    CubicBezierBoxIntersection::CubicBezierBoxIntersection(const CubicBezier2Desc& c, const Box& b, Real tmin, Real tmax)
+      : n_(0) {
+      // power basis coefficients, per coordinate (plain scalars: this is hot)
+      Real P[2][4];
+      for (int i = 0; i<4; ++i) {
+        P[0][i] = c.getCP(i).x;
+        P[1][i] = c.getCP(i).y;
+      }
+      Real k[2][4];
+      for (int d = 0; d<2; ++d) {
+        k[d][0] = -P[d][0] + 3.*P[d][1] - 3.*P[d][2] + P[d][3];
+        k[d][1] = 3.*P[d][0] - 6.*P[d][1] + 3.*P[d][2];
+        k[d][2] = -3.*P[d][0] + 3.*P[d][1];
+        k[d][3] = P[d][0];
+      }
 
-      r_.clear();
-      for (int i = 0; i<3; ++i)
-        if (r.isRootReal(i))
-          r_.push_back(r.getRealRoot(i));
+      Real lo[2], hi[2], bmin[2], bmax[2];
+      bmin[0] = b.getMinX(); bmax[0] = b.getMaxX();
+      bmin[1] = b.getMinY(); bmax[1] = b.getMaxY();
+      // the part of the curve in [tmin, tmax] lies in the hull of its control points
+      Real h = (tmax - tmin)/3.;
+      for (int d = 0; d<2; ++d) {
+        Real q0 = evalCubic(k[d][0], k[d][1], k[d][2], k[d][3], tmin);
+        Real q3 = evalCubic(k[d][0], k[d][1], k[d][2], k[d][3], tmax);
+        Real q1 = q0 + h*((3.*k[d][0]*tmin + 2.*k[d][1])*tmin + k[d][2]);
+        Real q2 = q3 - h*((3.*k[d][0]*tmax + 2.*k[d][1])*tmax + k[d][2]);
+        lo[d] = std::min(std::min(q0, q1), std::min(q2, q3));
+        hi[d] = std::max(std::max(q0, q1), std::max(q2, q3));
+      }
 
+      // slack when testing the other coordinate against the edge
+      const Real slack = 1e-9*(1. + std::max(b.width(), b.height()));
+
+      Real r[3];
+      // d = coordinate solved for (0: vertical edges, 1: horizontal edges), o = the other one
+      for (int d = 0; d<2; ++d) {
+        int o = 1-d;
+        if (bmin[o] > hi[o] + slack || bmax[o] < lo[o] - slack)
+          continue;
+        for (int side = 0; side<2; ++side) {
+          Real v = side ? bmax[d] : bmin[d];
+          if (v < lo[d] - slack || v > hi[d] + slack)
+            continue;
+          int n = solveCubicInRange(k[d][0], k[d][1], k[d][2], k[d][3] - v, tmin, tmax, r);
+          for (int i = 0; i<n; ++i) {
+            Real w = evalCubic(k[o][0], k[o][1], k[o][2], k[o][3], r[i]);
+            if (w < bmin[o] - slack || w > bmax[o] + slack)
+              continue;
+            // moving inwards through this edge?
+            Real dv = (3.*k[d][0]*r[i] + 2.*k[d][1])*r[i] + k[d][2];
+            t_[n_] = r[i];
+            dir_[n_] = side ? -dv : dv;
+            ++n_;
+          }
+        }
+      }
 
-      std::cerr << "CubicBezierIntersection: done\n";
+      // sort by parameter
+      for (int i = 1; i<n_; ++i)
+        for (int j = i; j>0 && t_[j] < t_[j-1]; --j) {
+          std::swap(t_[j], t_[j-1]);
+          std::swap(dir_[j], dir_[j-1]);
+        }
     }
 
     LinearIntersection::LinearIntersection(const Point& p1, const Point& p2, const Point& q1, const Point& q2) {
@@ -61,35 +61,50 @@ namespace Graphfab {
       return alpha*t*t*t + beta*t*t + gamma*t + delta;
     }
     
-    inline Point new2ndPos(const Point& first, const Point& second, const Real deg, const Real dist, const bool rel_dist) {
-        Real h, o, a, x;
-        Real hnew, onew, anew;
-        
-        o = second.y - first.y;
-        a = second.x - first.x;
-        h = sqrt(pow(a,2.) + pow(o,2.));
-        
-        if(rel_dist)
-            hnew = h + h*dist;
-        else
-            hnew = h + dist;
-        
+    /** @brief Rotate & extend the vector from @a first to @a second
+     * @details Same as @ref new2ndPos, but the rotation is given by its
+     * cosine @a cr and sine @a sr so that callers using a constant angle
+     * can compute them once.
+     */
+    inline Point new2ndPosRot(const Point& first, const Point& second, const Real cr, const Real sr, const Real dist, const bool rel_dist) {
+        const Real a = second.x - first.x;
+        const Real o = second.y - first.y;
         const Real ep = 1e-6;
-        
-        if(mag(a) > ep)
-            x = atan(o/a);
-        else
-            x = sign(o)*3.14159/2.;
-        
-        onew = hnew * sin(x + deg2r(deg));
-        anew = hnew * cos(x + deg2r(deg));
-        
-        if(second.x >= first.x)
-            return Point(first.x + anew, first.y + onew);
-        else
-            return Point(first.x - anew, first.y - onew);
+
+        if(mag(a) > ep) {
+            // hnew/h, with a single square root
+            const Real scale = rel_dist ? 1. + dist : 1. + dist/sqrt(a*a + o*o);
+            return Point(first.x + scale*(cr*a - sr*o), first.y + scale*(sr*a + cr*o));
+        }
+
+        // (near) vertical: the direction is taken as straight up / down
+        // (or along x if the points coincide), as the angle-based form did
+        const Real h = sqrt(a*a + o*o);
+        const Real hnew = rel_dist ? h + h*dist : h + dist;
+        const Real ux = (o == 0.) ? 1. : 0.;
+        const Real uy = sign(o);
+        const Real k = (second.x >= first.x) ? hnew : -hnew;
+        return Point(first.x + k*(cr*ux - sr*uy), first.y + k*(sr*ux + cr*uy));
     }
-    
+
+    /** @brief Rotate the vector from @a first to @a second by @a deg
+     * degrees and extend it by @a dist (relative to its length if
+     * @a rel_dist)
+     * @return The new position of @a second
+     */
+    inline Point new2ndPos(const Point& first, const Point& second, const Real deg, const Real dist, const bool rel_dist) {
+        if(deg == 0.)
+            return new2ndPosRot(first, second, 1., 0., dist, rel_dist);
+        const Real x = deg2r(deg);
+        return new2ndPosRot(first, second, cos(x), sin(x), dist, rel_dist);
+    }
+
+    /** @brief Batched @ref new2ndPos over @a n point pairs
+     * @details The rotation is computed once for all pairs.
+     * @param[out] result Room for @a n points; may alias @a second
+     */
+    _GraphfabExport void new2ndPos(const Point* first, const Point* second, uint64 n, const Real deg, const Real dist, const bool rel_dist, Point* result);
+
     // bounding box-based
     Point calcCurveBackup(const Point& src, const Point& cent, const Box& ext, Real dist = 20);
 
@@ -140,6 +155,56 @@ namespace Graphfab {
       std::vector<Real> r_;
     };
 
+    /** @brief Real roots of a*t^3 + b*t^2 + c*t + d lying in [tmin, tmax]
+     * @details Uses @ref CubicRoots, falling back to the quadratic or linear
+     * formula when the leading coefficients vanish. Each root is polished
+     * with Newton steps and checked against the polynomial.
+     * @param[out] roots Room for three values, in ascending order
+     * @return The number of roots
+     */
+    _GraphfabExport int solveCubicInRange(Real a, Real b, Real c, Real d, Real tmin, Real tmax, Real* roots);
+
+    /** @brief Intersect every curve in @a curves with every line in @a lines
+     * @details Only roots on the curve (t in [0, 1]) are reported. The
+     * result for curve i and line j is stored at index k = i*nlines + j:
+     * @a counts[k] roots, in ascending order, starting at @a roots[3*k].
+     * @param[out] roots Room for 3*ncurves*nlines values
+     * @param[out] counts Room for ncurves*nlines values
+     * @return The total number of intersections
+     */
+    _GraphfabExport uint64 intersectCubicBeziersWithLines(const CubicBezier2Desc* curves, uint64 ncurves,
+                                                          const Line2Desc* lines, uint64 nlines,
+                                                          Real* roots, int* counts);
+
+    /** @brief Parameters at which a cubic Bezier crosses the boundary of a box
+     * @details Each edge of the box is solved for in closed form, so there
+     * is no iteration over the curve.
+     */
+    class _GraphfabExport CubicBezierBoxIntersection {
+    public:
+      /// Intersect the part of @a c with t in [tmin, tmax] with the edges of @a b
+      CubicBezierBoxIntersection(const CubicBezier2Desc& c, const Box& b, Real tmin = 0., Real tmax = 1.);
+
+      /// Number of crossings
+      int getNumIntersections() const { return n_; }
+
+      /// Parameter of the ith crossing (ascending order)
+      Real getIntersection(int i) const { return t_[i]; }
+
+      /// True if the curve enters the box at the ith crossing (going towards increasing t)
+      bool isEntering(int i) const { return dir_[i] > 0.; }
+
+      /// True if the curve leaves the box at the ith crossing
+      bool isLeaving(int i) const { return dir_[i] < 0.; }
+
+    protected:
+      /// At most three per edge
+      Real t_[12];
+      /// Inward component of the tangent
+      Real dir_[12];
+      int n_;
+    };
+
 //     class LinearIntersectionResults {
 //     public:
 //       const Point& p() { return p_; }
@@ -49,15 +49,10 @@
 
 namespace Graphfab {
     
-    struct cutout {
-        cutout(Real a, Real b, Real c, Real d)
-            : u(a), v(b), x(c), y(d) {}
-        Real u, v;
-        Real x, y;
-        
-        Real det() const { return u*y - v*x; }
-    };
-
+    /** @brief 2d affine transform
+     * @details Stored as the top two rows of the homogeneous 3x3 matrix;
+     * the bottom row is always (0, 0, 1).
+     */
     class _GraphfabExport Affine2d {
         protected:
             static Real min(Real x, Real y) {
@@ -70,40 +65,54 @@ namespace Graphfab {
             Affine2d() {
                 _e[0] = 1.; _e[1] = 0.; _e[2] = 0.;
                 _e[3] = 0.; _e[4] = 1.; _e[5] = 0.;
-                _e[6] = 0.; _e[7] = 0.; _e[8] = 1.;
             }
             
+            Affine2d(Real a, Real b, Real c,
+                     Real u, Real v, Real w) {
+                _e[0] = a; _e[1] = b; _e[2] = c;
+                _e[3] = u; _e[4] = v; _e[5] = w;
+            }
+            
+            /// The bottom row (@a x, @a y, @a z) must be (0, 0, 1)
             Affine2d(Real a, Real b, Real c,
                      Real u, Real v, Real w,
                      Real x, Real y, Real z) {
+                AT(x == 0. && y == 0. && z == 1., "Not an affine transform");
                 _e[0] = a; _e[1] = b; _e[2] = c;
                 _e[3] = u; _e[4] = v; _e[5] = w;
-                _e[6] = x; _e[7] = y; _e[8] = z;
             }
             
             /// Invert
-            Affine2d inv() const;
+            Affine2d inv() const {
+                const Real d = det();
+                const Real a =  _e[4]/d, b = -_e[1]/d;
+                const Real u = -_e[3]/d, v =  _e[0]/d;
+                return Affine2d(a, b, -(a*_e[2] + b*_e[5]),
+                                u, v, -(u*_e[2] + v*_e[5]));
+            }
             
             /// Det
-            Real det() const;
+            Real det() const { return _e[0]*_e[4] - _e[1]*_e[3]; }
             
             /// Access the specified row/column
             Real rc(int r, int c) const {
                 AT(0 <= r && r < 3, "Row out of range");
                 AT(0 <= c && c < 3, "Column out of range");
+                if(r == 2)
+                    return c == 2 ? 1. : 0.;
                 return _e[c+r*3];
             }
             
-            /// Access the specified row/column as reference
+            /// Access the specified row/column as reference (top two rows only)
             Real& rcref(int r, int c) {
-                AT(0 <= r && r < 3, "Row out of range");
+                AT(0 <= r && r < 2, "Row out of range");
                 AT(0 <= c && c < 3, "Column out of range");
                 return _e[c+r*3];
             }
             
             // Hacky
             Real scaleFactor() const {
-                return rc(0,0);
+                return _e[0];
             }
             
             void set(int i, int j, Real val) { rcref(i,j) = val; }
@@ -111,19 +120,15 @@ namespace Graphfab {
             // Creators:
             
             static Affine2d makeXlate(Real x, Real y) {
-                Affine2d a;
-                a.rcref(0,2) = x;
-                a.rcref(1,2) = y;
-                return a;
+                return Affine2d(1., 0., x,
+                                0., 1., y);
             }
             
             static Affine2d makeXlate(const Point& p) { return makeXlate(p.x, p.y); }
             
             static Affine2d makeScale(Real x, Real y) {
-                Affine2d a;
-                a.rcref(0,0) = x;
-                a.rcref(1,1) = y;
-                return a;
+                return Affine2d( x, 0., 0.,
+                                0.,  y, 0.);
             }
             
             // usual basis transformation - z is xlate
@@ -131,8 +136,7 @@ namespace Graphfab {
             static Affine2d fromPoints(const Point& x, const Point& y, const Point& z) {
                 return Affine2d(
                     x.x, y.x, z.x,
-                    x.y, y.y, z.y,
-                     0.,  0.,  1.
+                    x.y, y.y, z.y
                 );
             }
 
@@ -140,8 +144,7 @@ namespace Graphfab {
             static Affine2d fromBasis(const Point& u, const Point& v,  const Point& disp) {
               return Affine2d(
                 u.x, v.x, disp.x,
-                u.y, v.y, disp.y, 
-                  0,   0, 1
+                u.y, v.y, disp.y
                 );
             }
             
@@ -157,22 +160,38 @@ namespace Graphfab {
             
             // Operations:
             
-            Point operator*(const Point& x) const;
+            Point operator*(const Point& x) const {
+                return Point(_e[0]*x.x + _e[1]*x.y + _e[2],
+                             _e[3]*x.x + _e[4]*x.y + _e[5]);
+            }
             
             Box operator*(const Box& x) const;
             
+            /// Scales the matrix entries (not the implicit bottom row)
             Affine2d operator*(const Real& k) const;
             
             Affine2d operator/(const Real& k) const { return (*this)*(1./k); }
             
+            /// Apply to @a n points; @a out may alias @a in
+            void transformPoints(const Point* in, Point* out, size_t n) const;
+            
             // Composition:
             
-            static Affine2d compose(const Affine2d& u, const Affine2d& v);
+            static Affine2d compose(const Affine2d& u, const Affine2d& v) {
+                const Real* a = u._e;
+                const Real* b = v._e;
+                return Affine2d(
+                    a[0]*b[0] + a[1]*b[3], a[0]*b[1] + a[1]*b[4], a[0]*b[2] + a[1]*b[5] + a[2],
+                    a[3]*b[0] + a[4]*b[3], a[3]*b[1] + a[4]*b[4], a[3]*b[2] + a[4]*b[5] + a[5]);
+            }
             
             Affine2d operator*(const Affine2d& z) const { return compose(*this, z); }
 
             /// Discard displacement
-            Point applyLinearOnly(const Point& x) const;
+            Point applyLinearOnly(const Point& x) const {
+                return Point(_e[0]*x.x + _e[1]*x.y,
+                             _e[3]*x.x + _e[4]*x.y);
+            }
 
             Point getScale() const {
               return Point(applyLinearOnly(Point(1, 0)).mag(),
@@ -180,19 +199,75 @@ namespace Graphfab {
             }
 
             Point getDisplacement() const {
-              return Point(rc(0, 2), rc(1, 2));
+              return Point(_e[2], _e[5]);
             }
             
         protected:
             
-            Affine2d cofactors() const;
+            Real _e[6];
+    };
+    
+    /** @brief A transform and its inverse, shared between elements
+     * @details Copies refer to the same (immutable) pair, so a network
+     * can hand one transform to all of its elements. Setting either
+     * half detaches from the shared pair. The default is the identity
+     * and allocates nothing.
+     */
+    class _GraphfabExport SharedTransform {
+        public:
+            SharedTransform()
+              : p_(NULL) {}
+            
+            SharedTransform(const Affine2d& tf, const Affine2d& itf)
+              : p_(new Rep(tf, itf)) {}
+            
+            SharedTransform(const SharedTransform& other)
+              : p_(other.p_) {
+                if(p_)
+                    ++p_->refs;
+            }
+            
+            ~SharedTransform() { release(); }
+            
+            SharedTransform& operator=(const SharedTransform& other) {
+                if(other.p_)
+                    ++other.p_->refs;
+                release();
+                p_ = other.p_;
+                return *this;
+            }
+            
+            const Affine2d& getTransform() const { return p_ ? p_->tf : identity(); }
             
-            Real cofactor(int i, int j) const;
+            const Affine2d& getInverse() const { return p_ ? p_->itf : identity(); }
+            
+            void setTransform(const Affine2d& tf) { *this = SharedTransform(tf, getInverse()); }
+            
+            void setInverse(const Affine2d& itf) { *this = SharedTransform(getTransform(), itf); }
+            
+            /// True if both refer to the same pair
+            bool isSharedWith(const SharedTransform& other) const { return p_ == other.p_; }
+
+            /// Opaque key, equal for transforms that share a pair (NULL for identity)
+            const void* getSharingKey() const { return p_; }
+            
+        protected:
+            struct Rep {
+                Rep(const Affine2d& tf_, const Affine2d& itf_)
+                  : tf(tf_), itf(itf_), refs(1) {}
+                Affine2d tf, itf;
+                unsigned long refs;
+            };
+            
+            void release() {
+                if(p_ && !--p_->refs)
+                    delete p_;
+                p_ = NULL;
+            }
             
-            // minor for row, col
-            cutout getCutout(int r, int c) const;
+            static const Affine2d& identity();
             
-            Real _e[9];
+            Rep* p_;
     };
     
     Point xformPoint(const Point& p, const Affine2d& t);
@@ -41,6 +41,9 @@
 
 #include <exception>
 #include <typeinfo>
+#include <algorithm>
+#include <unordered_set>
+#include <random>
 #include <math.h>
 #include <stdlib.h> //rand
 
@@ -160,8 +163,10 @@ namespace Graphfab {
             return;
         AT(_type != NET_ELT_TYPE_COMP);
 //         _p = _p + _v*scale;
-        if (_v.mag2() > 1e-6)
+        if (_v.mag2() > 1e-6) {
           _p = _p + _v.normed()*scale;
+          markMoved();
+        }
     }
 
     void NetworkElement::addDelta(const Point& d) {
@@ -180,19 +185,26 @@ namespace Graphfab {
         _p = p;
         _pset = 1;
         recalcExtents();
+        markMoved();
     }
 
     void NetworkElement::setGlobalCentroid(const Point& p) {
-        _p = itf_*p;
+        _p = xf_.getInverse()*p;
         _pset = 1;
         recalcExtents();
+        markMoved();
+    }
+
+    void NetworkElement::markMoved() {
+        if(getIndexingNetwork() && !isMarkedMoved())
+            getIndexingNetwork()->eltMoved(this);
     }
 
     Point NetworkElement::getCentroid(COORD_SYSTEM coord) const {
       if (coord == COORD_SYSTEM_LOCAL)
         return _p;
       else if (coord == COORD_SYSTEM_GLOBAL)
-        return tf_*_p;
+        return xf_.getTransform()*_p;
       else {
         AN(0, "Unknown coord system");
         return _p;
@@ -272,7 +284,10 @@ namespace Graphfab {
     }
 
     void Node::setId(const std::string& id) {
+        std::string old(_id);
         _id = id;
+        if(getIndexingNetwork())
+            getIndexingNetwork()->eltIdChanged(this, old);
     }
 
     const std::string& Node::getGlyph() const {
@@ -280,24 +295,22 @@ namespace Graphfab {
     }
 
     void Node::setGlyph(const std::string& id) {
+        std::string old(_gly);
         _gly = id;
+        if(getIndexingNetwork())
+            getIndexingNetwork()->eltGlyphChanged(this, old);
     }
 
     int Node::alias(Network* net) {
         if(!net->containsNode(this))
           SBNW_THROW(InvalidParameterException, "No such node in network", "Network::alias");
 
-        net->clearExcludeFromSubgraphEnum();
-        int nsub_before = net->getNumSubgraphs();
-
-        net->clearExcludeFromSubgraphEnum();
-        setExcludeFromSubgraphEnum();
-        int nsub_after = net->getNumSubgraphs();
-
-        if (nsub_before !=  nsub_after)
+        net->enumerateSubgraphs();
+        if (net->splitsSubgraph(this))
           return 1;
 
-        for (Network::RxnIt i=net->RxnsBegin(); i!=net->RxnsEnd(); ++i) {
+        Network::AttachedRxnList rxns = net->getConnectedReactions(this);
+        for (Network::AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
           Reaction* r = *i;
           int k = 0;
 
@@ -311,7 +324,7 @@ namespace Graphfab {
             if (c->ns != this && c->ne != this)
               continue;
 
-            Node* n = new Node();
+            Node* n = net->newNode();
 
             n->setName(getName());
 
@@ -332,8 +345,7 @@ namespace Graphfab {
             n->set_i(net->getUniqueIndex());
 
             n->setCentroid(new2ndPos(c->getCentroidCP(), getCentroid(), 0., -50., false));
-            n->setTransform(tf_,  false);
-            n->setInverseTransform(itf_,  false);
+            n->shareTransform(xf_, false);
 
             net->addNode(n);
 
@@ -359,6 +371,17 @@ namespace Graphfab {
         return 0;
     }
 
+    void Node::attachReaction(Reaction* r) {
+        if(std::find(rxns_.rxns.begin(), rxns_.rxns.end(), r) == rxns_.rxns.end())
+            rxns_.rxns.push_back(r);
+    }
+
+    void Node::detachReaction(Reaction* r) {
+        std::vector<Reaction*>::iterator i = std::find(rxns_.rxns.begin(), rxns_.rxns.end(), r);
+        if(i != rxns_.rxns.end())
+            rxns_.rxns.erase(i);
+    }
+
     bool Node::isCommonInstance(const Node* other) const {
         return getId() == other->getId();
     }
@@ -375,23 +398,25 @@ namespace Graphfab {
         Point d(w/2., getHeight()/2.);
         _ext.setMin(getCentroid() - d);
         _ext.setMax(getCentroid() + d);
+        markMoved();
     }
 
     void Node::setHeight(Real h) {
         Point d(getWidth()/2., h/2.);
         _ext.setMin(getCentroid() - d);
         _ext.setMax(getCentroid() + d);
+        markMoved();
     }
 
     void Node::affectGlobalWidth(Real ww) {
-        Real w = ww/tf_.scaleFactor();
+        Real w = ww/xf_.getTransform().scaleFactor();
         Point d(w/2., getHeight()/2.);
         _ext.setMin(getCentroid() - d);
         _ext.setMax(getCentroid() + d);
     }
 
     void Node::affectGlobalHeight(Real hh) {
-        Real h = hh/tf_.scaleFactor();
+        Real h = hh/xf_.getTransform().scaleFactor();
         Point d(getWidth()/2., h/2.);
         _ext.setMin(getCentroid() - d);
         _ext.setMax(getCentroid() + d);
@@ -484,12 +509,25 @@ namespace Graphfab {
 
     //--CLASS Reaction--
 
+    Reaction::~Reaction() {
+        for(NodeIt i=NodesBegin(); i!=NodesEnd(); ++i)
+            i->first->detachReaction(this);
+    }
+
     void Reaction::hierarchRelease() {
         deleteCurves();
     }
 
+    void Reaction::setId(const std::string& id) {
+        std::string old(_id);
+        _id = id;
+        if(getIndexingNetwork())
+            getIndexingNetwork()->eltIdChanged(this, old);
+    }
+
     void Reaction::addSpeciesRef(Node* n, RxnRoleType role) {
         _spec.push_back(std::make_pair(n, role));
+        n->attachReaction(this);
         // recompute curves
         _cdirty = 1;
         // increase degree
@@ -515,8 +553,10 @@ namespace Graphfab {
                 goto repeat; // in case the species shows up multiple times
             }
         }
-        if(rebuild)
+        if(rebuild) {
+            n->detachReaction(this);
             rebuildCurves();
+        }
     }
 
     Node* Reaction::findSpeciesById(const std::string& id) {
@@ -550,23 +590,28 @@ namespace Graphfab {
     }
 
     void Reaction::substituteSpeciesById(const std::string& id, Node* spec) {
+        std::vector<Node*> replaced;
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
             if(n->getId() == id) {
                 --n->_ldeg;
                 ++spec->_ldeg;
                 i->first = spec;
+                replaced.push_back(n);
             }
         }
+        updateIncidence(replaced, spec);
     }
 
     void Reaction::substituteSpeciesByIdwRole(const std::string& id, Node* spec, RxnRoleType role) {
+        std::vector<Node*> replaced;
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
             if(n->getId() == id && matchSBML_RoleGenericMod(i->second, role)) {
                 --n->_ldeg;
                 ++spec->_ldeg;
                 i->first = spec;
+                replaced.push_back(n);
                 // SBML inconsistency
                 if ((i->second == RXN_ROLE_MODIFIER) && (role == RXN_ROLE_ACTIVATOR || role == RXN_ROLE_INHIBITOR) ) {
 //                   std::cerr << "Set role for " << spec->getId() << " to " << rxnRoleToString(role) << "\n";
@@ -574,6 +619,7 @@ namespace Graphfab {
                 }
             }
         }
+        updateIncidence(replaced, spec);
     }
 
     RxnRoleType Reaction::getSpeciesRole(Node* x) {
@@ -587,14 +633,26 @@ namespace Graphfab {
     }
 
     void Reaction::substituteSpecies(Node* before, Node* after) {
+        std::vector<Node*> replaced;
         for(NodeVec::iterator i=_spec.begin(); i!=_spec.end(); ++i) {
             Node* n = i->first;
             if(n == before) {
                 --n->_ldeg;
                 ++after->_ldeg;
                 i->first = after;
+                replaced.push_back(n);
             }
         }
+        updateIncidence(replaced, after);
+    }
+
+    void Reaction::updateIncidence(const std::vector<Node*>& replaced, Node* spec) {
+        if(replaced.empty())
+            return;
+        spec->attachReaction(this);
+        for(std::vector<Node*>::const_iterator i=replaced.begin(); i!=replaced.end(); ++i)
+            if(*i != spec && !hasSpecies(*i))
+                (*i)->detachReaction(this);
     }
 
     Reaction::CurveVec& Reaction::getCurves() {
@@ -604,8 +662,23 @@ namespace Graphfab {
 
 #define REBUILD_CURVES_DIAG 0
 
+    // reuse a spare curve of the given type; NULL if there is none
+    static RxnBezier* takeSpareCurve(Reaction::CurveVec& spare, RxnCurveType type) {
+        for(Reaction::CurveIt i=spare.begin(); i!=spare.end(); ++i) {
+            RxnBezier* c = *i;
+            if(c->getRole() == type && !c->owns && !c->owne) {
+                spare.erase(i);
+                c->ns = c->ne = NULL;
+                return c;
+            }
+        }
+        return NULL;
+    }
+
     void Reaction::rebuildCurves() {
-        deleteCurves();
+        // recycle the old curves (and the vector's storage)
+        _spare.swap(_curv);
+        _curv.clear();
 
 # if REBUILD_CURVES_DIAG
         std::cerr << "Rebuild curves\n";
@@ -622,7 +695,9 @@ namespace Graphfab {
             switch(r) {
                 case RXN_ROLE_SUBSTRATE:
                 case RXN_ROLE_SIDESUBSTRATE:
-                    curv = new SubCurve();
+                    curv = takeSpareCurve(_spare, RXN_CURVE_SUBSTRATE);
+                    if(!curv)
+                        curv = new SubCurve();
                     curv->as = &n->_p;
                     curv->ns = n;
                     curv->owns = 0; //weak ref
@@ -631,7 +706,9 @@ namespace Graphfab {
                     break;
                 case RXN_ROLE_PRODUCT:
                 case RXN_ROLE_SIDEPRODUCT:
-                    curv = new PrdCurve();
+                    curv = takeSpareCurve(_spare, RXN_CURVE_PRODUCT);
+                    if(!curv)
+                        curv = new PrdCurve();
                     curv->as = &_p;
                     curv->owns = 0; //weak ref
                     curv->ae = &n->_p;
@@ -639,7 +716,9 @@ namespace Graphfab {
                     curv->owne = 0; //weak ref
                     break;
                 case RXN_ROLE_MODIFIER:
-                    curv = new ModCurve();
+                    curv = takeSpareCurve(_spare, RXN_CURVE_MODIFIER);
+                    if(!curv)
+                        curv = new ModCurve();
                     curv->as = &n->_p;
                     curv->ns = n;
                     curv->owns = 0; //weak ref
@@ -647,7 +726,9 @@ namespace Graphfab {
                     curv->owne = 0; //weak ref
                     break;
                 case RXN_ROLE_ACTIVATOR:
-                    curv = new ActCurve();
+                    curv = takeSpareCurve(_spare, RXN_CURVE_ACTIVATOR);
+                    if(!curv)
+                        curv = new ActCurve();
                     curv->as = &n->_p;
                     curv->ns = n;
                     curv->owns = 0; //weak ref
@@ -655,7 +736,9 @@ namespace Graphfab {
                     curv->owne = 0; //weak ref
                     break;
                 case RXN_ROLE_INHIBITOR:
-                    curv = new InhCurve();
+                    curv = takeSpareCurve(_spare, RXN_CURVE_INHIBITOR);
+                    if(!curv)
+                        curv = new InhCurve();
                     curv->as = &n->_p;
                     curv->ns = n;
                     curv->owns = 0; //weak ref
@@ -671,11 +754,14 @@ namespace Graphfab {
             std::cerr << "  Curve type: " << CurveTypeToString(curv->getRole()) << "\n";
 # endif
 
-            curv->setTransform(tf_);
-            curv->setInverseTransform(itf_);
+            curv->shareTransform(xf_);
             _curv.push_back(curv);
         }
 
+        for(CurveIt i=_spare.begin(); i!=_spare.end(); ++i)
+            delete *i;
+        _spare.clear();
+
         recalcCurveCPs();
 
         _cdirty = 0;
@@ -1012,6 +1098,7 @@ namespace Graphfab {
       }
       // normalize
       _p = _p*(1./count);
+      markMoved();
     }
 
     void Reaction::deleteCurves() {
@@ -1045,6 +1132,20 @@ namespace Graphfab {
 
     //--CLASS Compartment--
 
+    void Compartment::setId(const std::string& id) {
+        std::string old(_id);
+        _id = id;
+        if(getIndexingNetwork())
+            getIndexingNetwork()->eltIdChanged(this, old);
+    }
+
+    void Compartment::setGlyph(const std::string& glyph) {
+        std::string old(_gly);
+        _gly = glyph;
+        if(getIndexingNetwork())
+            getIndexingNetwork()->eltGlyphChanged(this, old);
+    }
+
     void Compartment::addElt(NetworkElement* e) {
         _elt.push_back(e);
     }
@@ -1099,8 +1200,10 @@ namespace Graphfab {
     void Compartment::autoSize() {
         uint64 count = _elt.size();
         Real dim = 350*sqrt((Real)count);
-        // avoid singularities in layout algo
-        Point shake((rand()%1000)/100.,(rand()%1000)/100.);
+        // avoid singularities in layout algo; derived from the id rather
+        // than rand() so that loading a model is reproducible
+        size_t h = std::hash<std::string>()(getId());
+        Point shake((h%1000)/100.,((h/1000)%1000)/100.);
         _ext = Box(Point(0,0) + shake, Point(dim,dim) + shake);
 		//_ext = Box(Point(0, 0), Point(dim, dim));
         _ra = _ext.area();
@@ -1212,30 +1315,109 @@ namespace Graphfab {
 
     //--CLASS Network--
 
-    void Network::hierarchRelease() {
-        // FIXME: replace with hierarch free
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            // (*i)->hierarchRelease();
-            delete *i;
+    // add x to an index under key (keeping the earlier element if the key is
+    // taken); appended = x is at the end of elts
+    template <class T>
+    static void indexElt(std::unordered_map<std::string, T*>& index, const std::string& key, T* x, const std::vector<T*>& elts, bool appended) {
+        if(key.empty())
+            return;
+        typename std::unordered_map<std::string, T*>::iterator i = index.find(key);
+        if(i == index.end()) {
+            index.insert(std::make_pair(key, x));
+            return;
         }
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            (*i)->hierarchRelease();
-            delete *i;
+        if(appended || i->second == x)
+            return;
+        for(typename std::vector<T*>::const_iterator j=elts.begin(); j!=elts.end(); ++j) {
+            if(*j == i->second)
+                return;
+            if(*j == x) {
+                i->second = x;
+                return;
+            }
         }
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            // (*i)->hierarchRelease();
-            delete *i;
+    }
+
+    // remove x from an index, handing the key to the next element that has it
+    template <class T>
+    static void unindexElt(std::unordered_map<std::string, T*>& index, const std::string& key, T* x, const std::vector<T*>& elts, const std::string& (T::*get)() const) {
+        typename std::unordered_map<std::string, T*>::iterator i = index.find(key);
+        if(i == index.end() || i->second != x)
+            return;
+        index.erase(i);
+        for(typename std::vector<T*>::const_iterator j=elts.begin(); j!=elts.end(); ++j) {
+            if(*j != x && ((*j)->*get)() == key) {
+                index.insert(std::make_pair(key, *j));
+                return;
+            }
         }
     }
 
+    // look up key, falling back to a search for the (unindexed) empty key
+    template <class T>
+    static T* findIndexed(const std::unordered_map<std::string, T*>& index, const std::string& key, const std::vector<T*>& elts, const std::string& (T::*get)() const) {
+        if(key.empty()) {
+            for(typename std::vector<T*>::const_iterator j=elts.begin(); j!=elts.end(); ++j)
+                if(((*j)->*get)() == key)
+                    return *j;
+            return NULL;
+        }
+        typename std::unordered_map<std::string, T*>::const_iterator i = index.find(key);
+        return i != index.end() ? i->second : NULL;
+    }
+
+    // destroy an element without returning its memory to the arena
+    template <class T>
+    static void destroyElt(T* x, Arena& arena) {
+        if(x->getArena() == &arena)
+            x->~T();
+        else
+            Network::releaseElt(x);
+    }
+
+    void Network::hierarchRelease() {
+        clearMoved();
+        // only elements indexed by this network belong to it; temporary
+        // sub-networks hold elements of another network and leave them alone
+        // reactions first: they detach themselves from their species
+        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i)
+            if((*i)->getIndexingNetwork() == this) {
+                (*i)->hierarchRelease();
+                destroyElt(*i, eltArena_);
+            }
+        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i)
+            if((*i)->getIndexingNetwork() == this)
+                destroyElt(*i, eltArena_);
+        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i)
+            if((*i)->getIndexingNetwork() == this)
+                destroyElt(*i, eltArena_);
+        _rxn.clear();
+        _nodes.clear();
+        _comp.clear();
+        _elt.clear();
+        nodeById_.clear();
+        nodeByGlyph_.clear();
+        rxnById_.clear();
+        sharedRxns_.clear();
+        compById_.clear();
+        compByGlyph_.clear();
+        // then free the arena's memory all at once
+        eltArena_.release();
+    }
+
     void Network::addNode(Node* n) {
         AN(n, "No node to add");
         _nodes.push_back(n);
         addElt(n);
+        if(!n->getIndexingNetwork())
+            n->setIndexingNetwork(this);
+        indexElt(nodeById_, n->getId(), n, _nodes, true);
+        indexElt(nodeByGlyph_, n->getGlyph(), n, _nodes, true);
     }
 
     void Network::removeReactionsForNode(Node* n) {
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+        AttachedRxnList rxns = getConnectedReactions(n);
+        for(AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
             (*i)->removeNode(n);
         }
     }
@@ -1254,6 +1436,12 @@ namespace Graphfab {
             Node* x = *i;
             if(x == n) {
                 _nodes.erase(i);
+                unindexElt(nodeById_, n->getId(), n, _nodes, &Node::getId);
+                unindexElt(nodeByGlyph_, n->getGlyph(), n, _nodes, &Node::getGlyph);
+                if(n->getIndexingNetwork() == this) {
+                    forgetMoved(n);
+                    n->setIndexingNetwork(NULL);
+                }
                 std::cout << "Removed node " << n << "\n";
                 return;
             }
@@ -1285,23 +1473,11 @@ namespace Graphfab {
     }
 
     Node* Network::findNodeById(const std::string& id) {
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* n = *i;
-            if(n->getId() == id)
-                return n;
-        }
-        //not found
-        return NULL;
+        return findIndexed(nodeById_, id, _nodes, &Node::getId);
     }
 
     const Node* Network::findNodeById(const std::string& id) const {
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            const Node* n = *i;
-            if(n->getId() == id)
-                return n;
-        }
-        //not found
-        return NULL;
+        return findIndexed(nodeById_, id, _nodes, &Node::getId);
     }
 
     std::string Network::getUniqueId() const {
@@ -1350,13 +1526,7 @@ namespace Graphfab {
     }
 
     Node* Network::findNodeByGlyph(const std::string& gly) {
-        for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* n = *i;
-            if(n->getGlyph() == gly)
-                return n;
-        }
-        //not found
-        return NULL;
+        return findIndexed(nodeByGlyph_, gly, _nodes, &Node::getGlyph);
     }
 
     Node* Network::getUniqueNodeAt(const size_t n) {
@@ -1426,11 +1596,15 @@ namespace Graphfab {
         return false;
     }
 
+    bool Network::isMemberReaction(const Reaction* r) const {
+        return r->getIndexingNetwork() == this || sharedRxns_.count(r);
+    }
+
     Network::AttachedRxnList Network::getConnectedReactions(const Node* n) {
         AttachedRxnList result;
-        for(ConstRxnIt i = RxnsBegin(); i != RxnsEnd(); ++i) {
+        for(std::vector<Reaction*>::const_iterator i=n->getReactions().begin(); i!=n->getReactions().end(); ++i) {
             Reaction* x = *i;
-            if(x->hasSpecies(n))
+            if(isMemberReaction(x))
                 result.push_back(x);
         }
         return result;
@@ -1455,14 +1629,70 @@ namespace Graphfab {
         return nsub_;
     }
 
+    // union-find root with path halving
+    static size_t subgraphRoot(std::vector<size_t>& parent, size_t x) {
+        while(parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
     void Network::enumerateSubgraphs() {
+        clearSubgraphInfo();
         nsub_ = 0;
-        loop:
-        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
-            Node* x = *i;
-            if(!x->isSetSubgraphIndex()) {
-                propagateSubgraphIndex(x, nsub_++);
-                goto loop;
+
+        std::unordered_map<const Node*, size_t> pos;
+        pos.reserve(_nodes.size());
+        for(size_t k=0; k<_nodes.size(); ++k)
+            pos.insert(std::make_pair(_nodes[k], k));
+
+        std::vector<size_t> parent(_nodes.size()), rank(_nodes.size(), 0);
+        for(size_t k=0; k<parent.size(); ++k)
+            parent[k] = k;
+
+        // join all species of each reaction
+        for(RxnVec::const_iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+            Reaction* r = *i;
+            bool first = true;
+            size_t a = 0;
+            for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                std::unordered_map<const Node*, size_t>::const_iterator p = pos.find(j->first);
+                if(p == pos.end())
+                    continue;
+                if(first) {
+                    a = subgraphRoot(parent, p->second);
+                    first = false;
+                    continue;
+                }
+                size_t b = subgraphRoot(parent, p->second);
+                if(a == b)
+                    continue;
+                if(rank[a] < rank[b])
+                    std::swap(a, b);
+                parent[b] = a;
+                if(rank[a] == rank[b])
+                    ++rank[a];
+            }
+        }
+
+        // number the roots in node order
+        std::vector<int> index(_nodes.size(), -1);
+        for(size_t k=0; k<_nodes.size(); ++k) {
+            size_t root = subgraphRoot(parent, k);
+            if(index[root] < 0)
+                index[root] = nsub_++;
+            _nodes[k]->setSubgraphIndex(index[root]);
+        }
+
+        for(RxnVec::const_iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+            Reaction* r = *i;
+            for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                std::unordered_map<const Node*, size_t>::const_iterator p = pos.find(j->first);
+                if(p != pos.end()) {
+                    r->setSubgraphIndex(_nodes[p->second]->getSubgraphIndex());
+                    break;
+                }
             }
         }
     }
@@ -1470,22 +1700,55 @@ namespace Graphfab {
     void Network::propagateSubgraphIndex(Node* x, int isub) {
         AT(!x->isSetSubgraphIndex(), "Subgraph index is already set");
         x->setSubgraphIndex(isub);
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            Reaction* r = *i;
-            if(r->hasSpecies(x)) {
-                for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++i) {
-                    if (!j->first->isSetSubgraphIndex())
-                        propagateSubgraphIndex(j->first, isub);
+        // iterative BFS; long chains would overflow the stack with recursion
+        std::vector<Node*> queue(1, x);
+        for(size_t k=0; k<queue.size(); ++k) {
+            AttachedRxnList rxns = getConnectedReactions(queue[k]);
+            for(AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i) {
+                Reaction* r = *i;
+                r->setSubgraphIndex(isub);
+                for(Reaction::NodeIt j=r->NodesBegin(); j!=r->NodesEnd(); ++j) {
+                    if (!j->first->isSetSubgraphIndex()) {
+                        j->first->setSubgraphIndex(isub);
+                        queue.push_back(j->first);
+                    }
                 }
             }
         }
     }
 
+    bool Network::splitsSubgraph(Node* x) {
+        const int isub = x->getSubgraphIndex();
+        // the other members of the subgraph
+        std::unordered_set<const Node*> members;
+        for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i)
+            if(*i != x && (*i)->getSubgraphIndex() == isub)
+                members.insert(*i);
+        if(members.empty())
+            return true;
+        // are they still connected without x?
+        std::unordered_set<const Node*> seen;
+        std::vector<const Node*> queue(1, *members.begin());
+        seen.insert(queue.front());
+        for(size_t k=0; k<queue.size(); ++k) {
+            AttachedRxnList rxns = getConnectedReactions(queue[k]);
+            for(AttachedRxnList::iterator i=rxns.begin(); i!=rxns.end(); ++i)
+                for(Reaction::NodeIt j=(*i)->NodesBegin(); j!=(*i)->NodesEnd(); ++j)
+                    if(members.count(j->first) && seen.insert(j->first).second)
+                        queue.push_back(j->first);
+        }
+        return seen.size() != members.size();
+    }
+
     void Network::clearSubgraphInfo() {
         for(NodeVec::const_iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
             Node* x = *i;
             x->clearSubgraphIndex();
         }
+        for(RxnVec::const_iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
+            Reaction* r = *i;
+            r->clearSubgraphIndex();
+        }
     }
 
     void Network::clearExcludeFromSubgraphEnum() {
@@ -1496,33 +1759,68 @@ namespace Graphfab {
     }
 
     Reaction* Network::findReactionById(const std::string& id) {
-        for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
-            Reaction* r = *i;
-            if(r->getId() == id)
-                return r;
-        }
-        //not found
-        return NULL;
+        return findIndexed(rxnById_, id, _rxn, &Reaction::getId);
     }
 
     Compartment* Network::findCompById(const std::string& id) {
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            Compartment* c = *i;
-            if(c->getId() == id)
-                return c;
-        }
-        //not found
-        return NULL;
+        return findIndexed(compById_, id, _comp, &Compartment::getId);
     }
 
     Compartment* Network::findCompByGlyph(const std::string& gly) {
-        for(CompVec::iterator i=_comp.begin(); i!=_comp.end(); ++i) {
-            Compartment* c = *i;
-            if(c->getGlyph() == gly)
-                return c;
+        return findIndexed(compByGlyph_, gly, _comp, &Compartment::getGlyph);
+    }
+
+    void Network::eltIdChanged(NetworkElement* e, const std::string& old) {
+        switch(e->getType()) {
+            case NET_ELT_TYPE_SPEC: {
+                Node* n = static_cast<Node*>(e);
+                unindexElt(nodeById_, old, n, _nodes, &Node::getId);
+                indexElt(nodeById_, n->getId(), n, _nodes, false);
+                break;
+            }
+            case NET_ELT_TYPE_RXN: {
+                Reaction* r = static_cast<Reaction*>(e);
+                unindexElt(rxnById_, old, r, _rxn, &Reaction::getId);
+                indexElt(rxnById_, r->getId(), r, _rxn, false);
+                break;
+            }
+            case NET_ELT_TYPE_COMP: {
+                Compartment* c = static_cast<Compartment*>(e);
+                unindexElt(compById_, old, c, _comp, &Compartment::getId);
+                indexElt(compById_, c->getId(), c, _comp, false);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void Network::eltGlyphChanged(NetworkElement* e, const std::string& old) {
+        switch(e->getType()) {
+            case NET_ELT_TYPE_SPEC: {
+                Node* n = static_cast<Node*>(e);
+                unindexElt(nodeByGlyph_, old, n, _nodes, &Node::getGlyph);
+                indexElt(nodeByGlyph_, n->getGlyph(), n, _nodes, false);
+                break;
+            }
+            case NET_ELT_TYPE_COMP: {
+                Compartment* c = static_cast<Compartment*>(e);
+                unindexElt(compByGlyph_, old, c, _comp, &Compartment::getGlyph);
+                indexElt(compByGlyph_, c->getGlyph(), c, _comp, false);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void Network::reindexComps() {
+        compById_.clear();
+        compByGlyph_.clear();
+        for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
+            indexElt(compById_, (*i)->getId(), *i, _comp, true);
+            indexElt(compByGlyph_, (*i)->getGlyph(), *i, _comp, true);
         }
-        //not found
-        return NULL;
     }
 
     void Network::resetUsageInfo() {
@@ -1532,10 +1830,24 @@ namespace Graphfab {
         }
     }
 
+    void Network::addCompartment(Compartment* c) {
+        _comp.push_back(c);
+        addElt(c);
+        if(!c->getIndexingNetwork())
+            c->setIndexingNetwork(this);
+        indexElt(compById_, c->getId(), c, _comp, true);
+        indexElt(compByGlyph_, c->getGlyph(), c, _comp, true);
+    }
+
     void Network::addReaction(Reaction* rxn) {
         AN(rxn);
         _rxn.push_back(rxn);
         addElt(rxn);
+        if(!rxn->getIndexingNetwork())
+            rxn->setIndexingNetwork(this);
+        else if(rxn->getIndexingNetwork() != this)
+            sharedRxns_.insert(rxn);
+        indexElt(rxnById_, rxn->getId(), rxn, _rxn, true);
     }
 
     void Network::removeReaction(Reaction* r) {
@@ -1546,6 +1858,12 @@ namespace Graphfab {
             Reaction* x = *i;
             if(x == r) {
                 _rxn.erase(i);
+                unindexElt(rxnById_, r->getId(), r, _rxn, &Reaction::getId);
+                sharedRxns_.erase(r);
+                if(r->getIndexingNetwork() == this) {
+                    forgetMoved(r);
+                    r->setIndexingNetwork(NULL);
+                }
                 std::cout << "Removed reaction " << r << "\n";
                 return;
             }
@@ -1574,9 +1892,10 @@ namespace Graphfab {
             if(!c->empty())
                 v.push_back(c);
             else
-                delete c;
+                releaseElt(c);
         }
         _comp.swap(v);
+        reindexComps();
     }
 
     Compartment* Network::findContainingCompartment(const NetworkElement* e) {
@@ -1638,16 +1957,19 @@ namespace Graphfab {
     }
 
     void Network::setTransform(const Affine2d& t, bool recurse) {
-        for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
-            NetworkElement* e = *i;
-            e->setTransform(t, recurse);
-        }
+        eltXf_.setTransform(t);
+        shareEltTransform(recurse);
     }
 
     void Network::setInverseTransform(const Affine2d& it, bool recurse) {
+        eltXf_.setInverse(it);
+        shareEltTransform(recurse);
+    }
+
+    void Network::shareEltTransform(bool recurse) {
         for(EltIt i=EltsBegin(); i!=EltsEnd(); ++i) {
             NetworkElement* e = *i;
-            e->setInverseTransform(it, recurse);
+            e->shareTransform(eltXf_, recurse);
         }
     }
 
@@ -1757,28 +2079,45 @@ namespace Graphfab {
         return d;
     }
 
-    void Network::randomizePositions(const Box& b) {
+    // rand_range, or a generator of its own when seeded
+    class PositionDraw {
+        public:
+            PositionDraw(uint64 seed) : seeded_(seed != 0), gen_(seed) {}
+
+            Real operator()(Real l, Real u) {
+                if(!seeded_)
+                    return rand_range(l, u);
+                return std::uniform_real_distribution<Real>(l, u)(gen_);
+            }
+
+        protected:
+            bool seeded_;
+            std::mt19937_64 gen_;
+    };
+
+    void Network::randomizePositions(const Box& b, uint64 seed) {
+        PositionDraw draw(seed);
         for(NodeVec::iterator i=_nodes.begin(); i!=_nodes.end(); ++i) {
             Node* n = *i;
             if(n->isLocked())
                 break;
-            n->setCentroid(rand_range(b.getMin().x, b.getMax().x),
-                           rand_range(b.getMin().y, b.getMax().y));
+            n->setCentroid(draw(b.getMin().x, b.getMax().x),
+                           draw(b.getMin().y, b.getMax().y));
         }
         for(RxnVec::iterator i=_rxn.begin(); i!=_rxn.end(); ++i) {
             Reaction* r = *i;
             if(r->isLocked())
                 break;
-            r->setCentroid(Point(rand_range(b.getMin().x, b.getMax().x),
-                            rand_range(b.getMin().y, b.getMax().y)));
+            r->setCentroid(Point(draw(b.getMin().x, b.getMax().x),
+                            draw(b.getMin().y, b.getMax().y)));
         }
         for(CompIt i=CompsBegin(); i!=CompsEnd(); ++i) {
             Graphfab::Compartment* c = *i;
             if(c->isLocked())
                 break;
             Real d = sqrt(c->restArea());
-            Point p(rand_range(b.getMin().x, b.getMax().x),
-                    rand_range(b.getMin().y, b.getMax().y));
+            Point p(draw(b.getMin().x, b.getMax().x),
+                    draw(b.getMin().y, b.getMax().y));
             Point dim(d, d);
             c->setExtents(Box(p-dim, p+dim));
         }
@@ -1792,6 +2131,56 @@ namespace Graphfab {
             r->rebuildCurves();
         }
         clipCurves();
+        clearMoved();
+    }
+
+    uint64 Network::recalcDirtyCurves(const Real padding, const Real clip_cutoff) {
+        // reactions affected by the moved elements
+        std::vector<Reaction*> dirty;
+        for(std::vector<NetworkElement*>::iterator i=moved_.begin(); i!=moved_.end(); ++i) {
+            NetworkElement* e = *i;
+            if(e->getType() == NET_ELT_TYPE_RXN) {
+                if(isMemberReaction((Reaction*)e))
+                    dirty.push_back((Reaction*)e);
+            } else if(e->getType() == NET_ELT_TYPE_SPEC) {
+                AttachedRxnList rxns = getConnectedReactions((Node*)e);
+                dirty.insert(dirty.end(), rxns.begin(), rxns.end());
+            }
+        }
+        clearMoved();
+
+        std::sort(dirty.begin(), dirty.end());
+        dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+
+        for(std::vector<Reaction*>::iterator i=dirty.begin(); i!=dirty.end(); ++i) {
+            Reaction* r = *i;
+            // getCurves rebuilds them first if the species changed
+            r->getCurves();
+            r->recalcCurveCPs();
+            r->clipCurves(padding, clip_cutoff);
+        }
+        return dirty.size();
+    }
+
+    void Network::eltMoved(NetworkElement* e) {
+        // compartments do not affect curves
+        if(moveTrackingPaused_ || e->getType() == NET_ELT_TYPE_COMP || e->isMarkedMoved())
+            return;
+        e->setMarkedMoved(true);
+        moved_.push_back(e);
+    }
+
+    void Network::forgetMoved(NetworkElement* e) {
+        if(!e->isMarkedMoved())
+            return;
+        e->setMarkedMoved(false);
+        moved_.erase(std::remove(moved_.begin(), moved_.end(), e), moved_.end());
+    }
+
+    void Network::clearMoved() {
+        for(std::vector<NetworkElement*>::iterator i=moved_.begin(); i!=moved_.end(); ++i)
+            (*i)->setMarkedMoved(false);
+        moved_.clear();
     }
 
     void Network::recalcCurveCPs() {
@@ -1886,7 +2275,7 @@ namespace Graphfab {
             } else {
                 //create an alias node
                 n->setAlias(true);
-                n = new Node(*n);
+                n = net->newNode(*n);
                 n->setGlyph(sg->getId());
                 n->_ldeg = 0;
                 //add alias node to the network
@@ -2080,7 +2469,7 @@ namespace Graphfab {
             // assume a compartment with the id "default" or "compartment" represents
             // a default, non-visual compartment, so discard it from the model
             if(comp->getId() != "default" && comp->getId() != "compartment" && comp->getId() != "graphfab_default_compartment" && (!haveDefaultCompartmentId() || getDefaultCompartmentId() !=  comp->getId())) {
-                Graphfab::Compartment* c = new Compartment();
+                Graphfab::Compartment* c = net->newCompartment();
 
                 // set id
                 c->setId(comp->getId());
@@ -2093,7 +2482,7 @@ namespace Graphfab {
         // add nodes
         //printf("# floating = %d\n", floating);
         for(int i=0; i<mod.getNumSpecies(); ++i) {
-            Node* n = new Node();
+            Node* n = net->newNode();
 
             const Species* s = mod.getSpecies(i);
 
@@ -2134,7 +2523,7 @@ namespace Graphfab {
         // add connections
         for(int i_rxn=0; i_rxn<mod.getNumReactions(); ++i_rxn) {
             const ::Reaction* rxn = mod.getReaction(i_rxn);
-            Reaction* r = new Reaction();
+            Reaction* r = net->newReaction();
 
             r->setId(rxn->getId());
 
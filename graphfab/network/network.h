@@ -43,6 +43,7 @@
 #include "graphfab/layout/curve.h"
 #include "graphfab/layout/box.h"
 #include "graphfab/math/transform.h"
+#include "graphfab/util/arena.h"
 
 //-- C++ code --
 #ifdef __cplusplus
@@ -55,6 +56,9 @@
 #include <string>
 #include <iostream>
 #include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <new>
 #include <stdint.h>
 
 namespace Graphfab {
@@ -243,6 +247,28 @@ namespace Graphfab {
         ELT_SHAPE_RECT
     } NetworkEltShape;
 
+    class Network;
+
+    /** @brief Weak reference from an element to the network whose lookup
+     * indexes hold it
+     * @details Not carried over when the element is copied: the copy is not
+     * in any index until it is added to a network.
+     */
+    class NetworkIndexRef {
+        public:
+            NetworkIndexRef()
+                : net(NULL), moved(false) {}
+
+            NetworkIndexRef(const NetworkIndexRef&)
+                : net(NULL), moved(false) {}
+
+            NetworkIndexRef& operator=(const NetworkIndexRef&) { return *this; }
+
+            Network* net;
+            /// True while the element is in the network's list of moved elements
+            bool moved;
+    };
+
     /** @brief An element that can be connected to other elements in the network
      */
     class NetworkElement {
@@ -256,6 +282,8 @@ namespace Graphfab {
             NetworkElement()
                 : _pset(0), _v(0,0), _deg(0), _ldeg(0), _lock(0), networkEltBytePattern_(0x1199) {}
 
+            virtual ~NetworkElement() {}
+
             /// Get the type
             NetworkEltType getType() const { return _type; }
 
@@ -277,6 +305,9 @@ namespace Graphfab {
             /// Adjust the velocity (set v = v + d)
             void addDelta(const Point& d);
 
+            /// Get the velocity (accumulated force)
+            const Point& getDelta() const { return _v; }
+
             /// Cap the velocity
             void capDelta(const Real cap);
 
@@ -293,6 +324,9 @@ namespace Graphfab {
 
             virtual bool isCentroidSet() const { return _pset; }
 
+            /// Mark the centroid as set (or not) without moving the element
+            void setCentroidSetFlag(bool b) { _pset = b; }
+
             /// Get the centroid of the node
             virtual Point getCentroid(COORD_SYSTEM coord = COORD_SYSTEM_LOCAL) const;
 
@@ -312,8 +346,8 @@ namespace Graphfab {
             Real getHeight() const { AT(getMaxY() >= getMinY()); return getMaxY() - getMinY(); }
 
             /// With/height derived from extents
-            Real getGlobalWidth() const { AT(getMaxX() >= getMinX()); return (getMaxX() - getMinX())*tf_.scaleFactor(); }
-            Real getGlobalHeight() const { AT(getMaxY() >= getMinY()); return (getMaxY() - getMinY())*tf_.scaleFactor(); }
+            Real getGlobalWidth() const { AT(getMaxX() >= getMinX()); return (getMaxX() - getMinX())*xf_.getTransform().scaleFactor(); }
+            Real getGlobalHeight() const { AT(getMaxY() >= getMinY()); return (getMaxY() - getMinY())*xf_.getTransform().scaleFactor(); }
 
             /** @brief Get bounding box
              */
@@ -322,7 +356,7 @@ namespace Graphfab {
                 case COORD_SYSTEM_LOCAL:
                   return getLocalExtents();
                 case COORD_SYSTEM_GLOBAL:
-                  return tf_*getLocalExtents();
+                  return xf_.getTransform()*getLocalExtents();
                 default:
                   AN(0, "Unknown coord system");
                   return getLocalExtents();
@@ -337,7 +371,7 @@ namespace Graphfab {
 //             virtual SAGITTARIUS_DEPRECATED(Box getGlobalExtents() const) { return tf_*_ext; }
 
             /// Set the extents of the compartment
-            void setExtents(const Box& b) { _ext = b; recalcCentroid(); }
+            void setExtents(const Box& b) { _ext = b; recalcCentroid(); markMoved(); }
 
             Box getBoundingBox() const { return getExtents(); }
 //             Box getBoundingBox() const { return Box(); }
@@ -345,11 +379,13 @@ namespace Graphfab {
             virtual void applyTransform(const Affine2d& t) {
                 _ext = xformBox(_ext, t);
                 _p = xformPoint(_p, t);
+                markMoved();
             }
 
             virtual void applyDisplacement(const Point& d) {
                 _ext.displace(d);
                 _p += d;
+                markMoved();
             }
 
             /// Calculate the centroid based on the extents
@@ -367,6 +403,24 @@ namespace Graphfab {
             // Is the node locked?
             bool isLocked() const { return _lock; }
 
+            /// The network which indexes this element by id & glyph (the first one it was added to)
+            Network* getIndexingNetwork() const { return index_.net; }
+
+            void setIndexingNetwork(Network* net) { index_.net = net; }
+
+            /// True if the element moved since the curves were last updated
+            bool isMarkedMoved() const { return index_.moved; }
+
+            void setMarkedMoved(bool b) { index_.moved = b; }
+
+            /// Tell the indexing network that this element's curves are out of date
+            void markMoved();
+
+            /// The arena holding this element, or NULL if it was allocated with new
+            Arena* getArena() const { return arena_.arena; }
+
+            void setArena(Arena* a) { arena_.arena = a; }
+
             NetworkEltShape getShape() const { return _shape; }
 
             //TODO: cache in member & ditch v func
@@ -396,13 +450,19 @@ namespace Graphfab {
             /// Dump info about forces
             virtual void dumpForces(std::ostream& os, uint32 ind) const = 0;
 
-            virtual Affine2d getTransform() const { return tf_; }
+            virtual Affine2d getTransform() const { return xf_.getTransform(); }
+
+            virtual void setTransform(const Affine2d& tf, bool recurse = true) { xf_.setTransform(tf); }
+
+            virtual Affine2d getInverseTransform() const { return xf_.getInverse(); }
 
-            virtual void setTransform(const Affine2d& tf, bool recurse = true) { tf_ = tf; }
+            virtual void setInverseTransform(const Affine2d& itf, bool recurse = true) { xf_.setInverse(itf); }
 
-            virtual Affine2d getInverseTransform() const { return itf_; }
+            /// The transform & inverse, possibly shared with other elements
+            const SharedTransform& getSharedTransform() const { return xf_; }
 
-            virtual void setInverseTransform(const Affine2d& itf, bool recurse = true) { itf_ = itf; }
+            /// Refer to @a xf instead of holding a private copy
+            virtual void shareTransform(const SharedTransform& xf, bool recurse = true) { xf_ = xf; }
 
             /// Centroid
             Point _p;
@@ -425,15 +485,34 @@ namespace Graphfab {
             NetworkEltType _type;
             /// Locked?
             int _lock;
-            /// Transform
-            Affine2d tf_;
-            /// Inverse transform
-            Affine2d itf_;
+            /// Transform & inverse
+            SharedTransform xf_;
+
+            /// Network to notify when the id or glyph changes
+            NetworkIndexRef index_;
+            /// Arena this element was allocated from
+            ArenaRef arena_;
 
             long networkEltBytePattern_;
     };
 
-    class Network;
+    class Reaction;
+
+    /** @brief The reactions which include a node
+     * @details Starts out empty when the node is copied, since the copy is
+     * not part of any reaction until it is added to one.
+     */
+    class ReactionIncidence {
+        public:
+            ReactionIncidence() {}
+
+            ReactionIncidence(const ReactionIncidence&) {}
+
+            ReactionIncidence& operator=(const ReactionIncidence&) { return *this; }
+
+            /// One entry per reaction, in the order the node was added to them
+            std::vector<Reaction*> rxns;
+    };
 
     /** @brief Node in a network
      */
@@ -448,6 +527,7 @@ namespace Graphfab {
                     _ext = Box(0,0,40,20);
                     bytepattern = 0xc455;
                     isub_ = -1;
+                    exsub_ = false;
                 }
 
             // Model:
@@ -486,8 +566,23 @@ namespace Graphfab {
             /// Specify if this node is an alias or not
             void setAlias(bool b) { _isAlias = b; }
 
+            /** @brief Replace this node by one alias per attached curve
+             * @details Returns 1 and leaves the network unchanged if that would
+             * change the number of subgraphs (see @ref Network::splitsSubgraph).
+             */
             int alias(Network* net);
 
+            // Incidence:
+
+            /// Reactions (in any network) which include this node
+            const std::vector<Reaction*>& getReactions() const { return rxns_.rxns; }
+
+            /// Called by a reaction when it starts to include the node
+            void attachReaction(Reaction* r);
+
+            /// Called by a reaction when it no longer includes the node
+            void detachReaction(Reaction* r);
+
             int getSubgraphIndex() const {
                 if (isub_ < 0)
                     SBNW_THROW(InvalidParameterException, "No subgraph index set", "Network::getSubgraphIndex");
@@ -496,7 +591,7 @@ namespace Graphfab {
 
             void setSubgraphIndex(int v) { isub_ = v; }
 
-            bool isSetSubgraphIndex() { return isub_ < 0; }
+            bool isSetSubgraphIndex() const { return isub_ >= 0; }
 
             void clearSubgraphIndex() { isub_ = -1; }
 
@@ -570,6 +665,8 @@ namespace Graphfab {
             size_t i_;
             int isub_;
             bool exsub_;
+            /// Reactions which include this node
+            ReactionIncidence rxns_;
     };
 
     /// Does runtime type checking
@@ -641,8 +738,13 @@ namespace Graphfab {
                     _shape = ELT_SHAPE_ROUND;
                     _type = NET_ELT_TYPE_RXN;
                     bytepattern = 0xff83;
+                    isub_ = -1;
+                    _cdirty = false;
                 }
 
+            /// Detaches the reaction from its species
+            ~Reaction();
+
             void hierarchRelease();
 
             // Model:
@@ -651,7 +753,10 @@ namespace Graphfab {
             const std::string& getId() const { return _id; }
 
             /// Set ID
-            void setId(const std::string& id) { _id = id; }
+            void setId(const std::string& id);
+
+            /// Get the reaction's name
+            const std::string& getName() const { return name_; }
 
             void setName(const std::string& name) { name_ = name; }
 
@@ -679,6 +784,22 @@ namespace Graphfab {
 
             RxnRoleType getSpeciesRole(Node* n);
 
+            // Subgraphs:
+
+            /// Index of the subgraph containing this reaction (set by @ref Network::enumerateSubgraphs)
+            int getSubgraphIndex() const {
+                if (isub_ < 0)
+                    SBNW_THROW(InvalidParameterException, "No subgraph index set", "Reaction::getSubgraphIndex");
+                return isub_;
+            }
+
+            void setSubgraphIndex(int v) { isub_ = v; }
+
+            /// False for reactions without species in the network
+            bool isSetSubgraphIndex() const { return isub_ >= 0; }
+
+            void clearSubgraphIndex() { isub_ = -1; }
+
             Node* getSpecies(size_t i) { return _spec.at(i).first; }
 
             /** @brief Substitute the new node for any species with given id
@@ -757,16 +878,23 @@ namespace Graphfab {
             }
 
             virtual void setTransform(const Affine2d& tf, bool recurse = true) {
-                tf_ = tf;
+                xf_.setTransform(tf);
                 for(CurveIt i = CurvesBegin(); i != CurvesEnd(); ++i) {
-                    (*i)->setTransform(tf);
+                    (*i)->shareTransform(xf_);
                 }
             }
 
             virtual void setInverseTransform(const Affine2d& itf, bool recurse = true) {
-                itf_ = itf;
+                xf_.setInverse(itf);
                 for(CurveIt i = CurvesBegin(); i != CurvesEnd(); ++i) {
-                    (*i)->setInverseTransform(itf);
+                    (*i)->shareTransform(xf_);
+                }
+            }
+
+            virtual void shareTransform(const SharedTransform& xf, bool recurse = true) {
+                xf_ = xf;
+                for(CurveIt i = CurvesBegin(); i != CurvesEnd(); ++i) {
+                    (*i)->shareTransform(xf_);
                 }
             }
 
@@ -780,11 +908,13 @@ namespace Graphfab {
 
             void clearDirtyFlag() { _cdirty = false; }
 
+            /// True if the curves will be rebuilt on next access
+            bool isDirty() const { return _cdirty; }
+
             /// Returns weak ref
             RxnBezier* addCurve(RxnRoleType role) {
                 _curv.push_back(RxnCurveFactory::CreateCurve(role));
-                _curv.back()->setTransform(itf_);
-                _curv.back()->setInverseTransform(itf_);
+                _curv.back()->shareTransform(xf_);
                 return _curv.back();
             }
 
@@ -810,6 +940,9 @@ namespace Graphfab {
                 }
             }
 
+            /// After substituting @a spec for the @a replaced species, keep their incidence lists in sync
+            void updateIncidence(const std::vector<Node*>& replaced, Node* spec);
+
             // Variables:
             // model:
             std::string _id;
@@ -827,8 +960,12 @@ namespace Graphfab {
             //RoleVec _role;
             /// Curves
             CurveVec _curv;
+            /// Old curves being recycled by @ref rebuildCurves
+            CurveVec _spare;
             /// Do curves need to be rebuilt?
             bool _cdirty;
+            /// Subgraph index
+            int isub_;
 
             long bytepattern;
     };
@@ -883,7 +1020,10 @@ namespace Graphfab {
             const std::string& getId() const { return _id; }
 
             /// Set the compartment's id
-            void setId(const std::string& id) { _id = id; }
+            void setId(const std::string& id);
+
+            /// Get the compartment's name
+            const std::string& getName() const { return name_; }
 
             /// Set the compartment's name
             void setName(const std::string& name) { name_ = name; }
@@ -892,7 +1032,7 @@ namespace Graphfab {
             const std::string& getGlyph() const { return _gly; }
 
             /// Set the compartment's glyph (layout element)
-            void setGlyph(const std::string& glyph) { _gly = glyph; }
+            void setGlyph(const std::string& glyph);
 
             void setCentroid(const Point& p) {
                 AN(0, "setCentroid should not be called on a compt");
@@ -926,6 +1066,9 @@ namespace Graphfab {
             /// Rest area
             Real restArea() const { return _ra; }
 
+            /// Set the rest area without touching the extents
+            void setRestArea(Real ra) { _ra = ra; }
+
             void setMin(const Point& p) { _ext.setMin(p); }
             void setMax(const Point& p) { _ext.setMax(p); }
 
@@ -1026,13 +1169,45 @@ namespace Graphfab {
             Network() {
                 bytepattern = 0x3355;
                 layoutspecified_ = false;
+                moveTrackingPaused_ = 0;
             }
 
+            /// Destroys the elements owned by the network (see @ref hierarchRelease)
+            virtual ~Network() { hierarchRelease(); }
+
             // Methods:
 
-            /// Destructor
+            /** @brief Destroy all elements owned by the network and empty it
+             * @details Elements owned by another network (those of a temporary
+             * sub-network) are only removed. Those from the arena are freed in one go.
+             */
             void hierarchRelease();
 
+            // Allocation:
+
+            /** @brief Create a node in the network's arena
+             * @details The node is not added to the network. It must be freed
+             * with @ref releaseElt (or @ref hierarchRelease) and cannot
+             * outlive the network.
+             */
+            Node* newNode() { return newElt<Node>(); }
+
+            /// Create a copy of @a other in the network's arena
+            Node* newNode(const Node& other) { return newElt<Node>(other); }
+
+            /// Create a reaction in the network's arena (see @ref newNode)
+            Reaction* newReaction() { return newElt<Reaction>(); }
+
+            /// Create a compartment in the network's arena (see @ref newNode)
+            Compartment* newCompartment() { return newElt<Compartment>(); }
+
+            /// Free an element, whether it came from an arena or from new
+            static void releaseElt(Node* x) { releaseEltT(x); }
+
+            static void releaseElt(Reaction* x) { releaseEltT(x); }
+
+            static void releaseElt(Compartment* x) { releaseEltT(x); }
+
             // Nodes:
 
             /// Add an unlinked node to the network
@@ -1078,20 +1253,34 @@ namespace Graphfab {
 
             typedef std::vector<Reaction*> AttachedRxnList;
 
+            /// Reactions in this network which include @a n (proportional to the degree of @a n)
             AttachedRxnList getConnectedReactions(const Node* n);
 
             typedef std::vector<RxnBezier*> AttachedCurveList;
 
             AttachedCurveList getAttachedCurves(const Node* n);
 
+            /// Enumerates the subgraphs and returns their number
             int getNumSubgraphs();
 
-            /// Enumerates all the subgraphs of the network and assigns each a unique index
+            /** @brief Enumerates all the subgraphs of the network and assigns each a unique index
+             * @details Union-find over the species of each reaction, so near-linear
+             * in the size of the network. Afterwards every node and every reaction
+             * with at least one species carries the index of its subgraph. Indices
+             * are numbered in order of the first node of each subgraph.
+             */
             void enumerateSubgraphs();
 
-            /// Assigns the index to all nodes in the subgraph containing @ref x
+            /// Assigns the index to all nodes and reactions in the subgraph containing @ref x
             void propagateSubgraphIndex(Node* x, int isub);
 
+            /** @brief True if removing @a x would change the number of subgraphs
+             * @details Either @a x is the only node of its subgraph or the
+             * rest of the subgraph falls apart without it. Uses the indices
+             * from @ref enumerateSubgraphs, so only the subgraph of @a x is visited.
+             */
+            bool splitsSubgraph(Node* x);
+
             void clearSubgraphInfo();
 
             void clearExcludeFromSubgraphEnum();
@@ -1128,7 +1317,7 @@ namespace Graphfab {
             // Compartments:
 
             /// Add a compartment
-            void addCompartment(Compartment* c) { _comp.push_back(c); addElt(c); }
+            void addCompartment(Compartment* c);
 
             /** @brief Find a compartment by id
              * @param[in] id Id of compartment elt
@@ -1165,21 +1354,40 @@ namespace Graphfab {
 
             void applyTransform(const Affine2d& t);
 
+            /// Set the transform of all elements, which share a single copy
             void setTransform(const Affine2d& t, bool recurse = true);
 
+            /// Set the inverse transform of all elements, which share a single copy
             void setInverseTransform(const Affine2d& it, bool recurse = true);
 
+            /// The copy set by @ref setTransform (elements added later do not share it automatically)
+            const SharedTransform& getSharedEltTransform() const { return eltXf_; }
+
             void applyDisplacement(const Point& d);
 
             /// Discard any empty compartments
             void elideEmptyComps();
 
-            /// Reset displacement deltas for all nodes & rxns
-            void randomizePositions(const Box& bounds);
+            /** @brief Place the unlocked elements at random within @a bounds
+             * @param[in] seed Draw from a generator with this seed instead of rand() (0 = rand())
+             */
+            void randomizePositions(const Box& bounds, uint64 seed = 0);
 
             /// Rebuild curves
             void rebuildCurves();
 
+            /** @brief Update only the curves affected by elements that moved
+             * @details Recalculates control points and reclips the curves of
+             * reactions which moved or which include a node that moved since
+             * the last call (or the last @ref rebuildCurves). Movement is
+             * recorded by the element setters; code that writes positions
+             * directly must call @ref rebuildCurves instead.
+             * @param padding     Amount to pad bounding boxes
+             * @param clip_cutoff Numeric tolerance for clipping algorithm
+             * @return Number of reactions updated
+             */
+            uint64 recalcDirtyCurves(const Real padding=0, const Real clip_cutoff=0.1);
+
             /** @brief Recalc the CPs for all curves
              */
             void recalcCurveCPs();
@@ -1279,10 +1487,46 @@ namespace Graphfab {
             ConstCompIt CompsEnd() const { return _comp.end(); }
 
             bool doByteCheck() const { if(bytepattern == 0x3355) return true; else return false; }
+
+            // Indexes:
+
+            /// Called by an indexed element after its id changes from @a old
+            void eltIdChanged(NetworkElement* e, const std::string& old);
+
+            /// Called by an indexed element after its glyph changes from @a old
+            void eltGlyphChanged(NetworkElement* e, const std::string& old);
+
+            /// Called by an indexed element after it moves or changes size
+            void eltMoved(NetworkElement* e);
+
+            /** @brief Stop recording moves until @ref resumeMoveTracking
+             * @details Elements report moves to their indexing network without
+             * locking, so tracking must be paused while they are moved from
+             * several threads (e.g. by the layout). Calls nest.
+             */
+            void pauseMoveTracking() { ++moveTrackingPaused_; }
+
+            void resumeMoveTracking() { --moveTrackingPaused_; }
+
         protected:
 
             void removeReactionsForNode(Node* n);
 
+            /// Rebuild the compartment indexes from @ref _comp
+            void reindexComps();
+
+            /// Drop @a e from the list of moved elements
+            void forgetMoved(NetworkElement* e);
+
+            /// Empty the list of moved elements
+            void clearMoved();
+
+            /// Point every element at @ref eltXf_
+            void shareEltTransform(bool recurse);
+
+            /// True if @a r is in this network (constant time)
+            bool isMemberReaction(const Reaction* r) const;
+
             /// Nodes (strong reference)
             NodeVec _nodes;
             /// Reactions
@@ -1290,11 +1534,62 @@ namespace Graphfab {
             /// Compartments
             CompVec _comp;
 
+            /** @brief Lookup tables for the find* methods
+             * @details Empty ids & glyphs are not indexed. Where several
+             * elements share a key (e.g. alias nodes share the id of the
+             * original) the table holds the first one in the container,
+             * which is what a linear search would return.
+             */
+            typedef std::unordered_map<std::string, Node*> NodeIndex;
+            typedef std::unordered_map<std::string, Reaction*> RxnIndex;
+            typedef std::unordered_map<std::string, Compartment*> CompIndex;
+            NodeIndex nodeById_, nodeByGlyph_;
+            RxnIndex rxnById_;
+            /// Member reactions indexed by another network (e.g. those of a temporary sub-network)
+            std::unordered_set<const Reaction*> sharedRxns_;
+            CompIndex compById_, compByGlyph_;
+
             long bytepattern;
             bool layoutspecified_;
 
             /// Number of subgraphs
             int nsub_;
+
+            template <class T>
+            T* newElt() {
+                T* x = new (eltArena_.allocate(sizeof(T))) T();
+                x->setArena(&eltArena_);
+                return x;
+            }
+
+            template <class T>
+            T* newElt(const T& other) {
+                T* x = new (eltArena_.allocate(sizeof(T))) T(other);
+                x->setArena(&eltArena_);
+                return x;
+            }
+
+            template <class T>
+            static void releaseEltT(T* x) {
+                if(!x)
+                    return;
+                if(Arena* a = x->getArena()) {
+                    x->~T();
+                    a->deallocate(x, sizeof(T));
+                } else
+                    delete x;
+            }
+
+            /// Storage for the elements created by this network
+            Arena eltArena_;
+
+            /// Elements which moved since the curves were last updated
+            std::vector<NetworkElement*> moved_;
+            /// Moves are not recorded while nonzero
+            int moveTrackingPaused_;
+
+            /// Transform shared by all elements
+            SharedTransform eltXf_;
     };
 
     /// Does runtime type checking
@@ -32,6 +32,7 @@
 #include "graphfab/interface/layout.h"
 #include "graphfab/layout/fr.h"
 #include "graphfab/util/string.h"
+#include "graphfab/draw/svg.h"
 #include "graphfab/draw/tikz.h"
 
 #include <stdlib.h>
@@ -1013,7 +1014,8 @@ static PyObject* gfp_Node_new(PyTypeObject *type, PyObject *args, PyObject *kwds
         return NULL;
     }
 
-    self->owning = 1;
+    // nodes belong to their network, which destroys them
+    self->owning = 0;
     
     return (PyObject*)self;
 }
@@ -1386,13 +1388,14 @@ static void gfp_Network_dealloc(gfp_Network* self) {
 //     printf("Network dealloc\n");
     #endif
 
-    gf_releaseNetwork(&self->n);
-
+    // drop the element handles before the network destroys the elements
     Py_XDECREF(self->nodes);
     Py_XDECREF(self->rxns);
     Py_XDECREF(self->comps);
     Py_XDECREF(self->uniquenodes);
 
+    gf_releaseNetwork(&self->n);
+
     Py_XDECREF(self->canv);
 
     Py_TYPE(self)->tp_free((PyObject*)self);
@@ -1553,8 +1556,9 @@ static PyObject* gfp_NetworkAutolayout(gfp_Network *self, PyObject *args, PyObje
     gf_canvas* c = NULL;
     //PyObject *k, *boundary, *mag, *grav, *bary, *autobary, *enablecomps, *prerandomize;
     PyObject* bary=NULL;
+    unsigned long long seed=0;
     static char *kwlist[] = {"canvas", "k", "boundary", "mag", "grav", "bary", 
-        "autobary", "enablecomps", "prerandomize", NULL};
+        "autobary", "enablecomps", "prerandomize", "repulsion", "theta", "parallel", "threads", "multilevel", "tolerance", "adaptive", "maxiter", "maxtime", "components", "warmstart", "cutoff", "correction", "seed", NULL};
     #if SAGITTARIUS_DEBUG_LEVEL >= 2
 //     printf("gfp_NetworkAutolayout called\n");
     #endif
@@ -1562,8 +1566,11 @@ static PyObject* gfp_NetworkAutolayout(gfp_Network *self, PyObject *args, PyObje
     gf_getLayoutOptDefaults(&opt);
     
     // parse args
-    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|O!" GF_PYREALFMT "ii" GF_PYREALFMT "Oiii", kwlist, 
-        &gfp_CanvasType, &canvas, &opt.k, &opt.boundary, &opt.mag, &opt.grav, &bary, &opt.autobary, &opt.enable_comps, &opt.prerandomize
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|O!" GF_PYREALFMT "ii" GF_PYREALFMT "Oiiii" GF_PYREALFMT "iii" GF_PYREALFMT "ii" GF_PYREALFMT "ii" GF_PYREALFMT "iK", kwlist, 
+        &gfp_CanvasType, &canvas, &opt.k, &opt.boundary, &opt.mag, &opt.grav, &bary, &opt.autobary, &opt.enable_comps, &opt.prerandomize,
+        &opt.repulsion, &opt.theta, &opt.parallel, &opt.threads, &opt.multilevel,
+        &opt.tolerance, &opt.adaptive, &opt.maxiter, &opt.maxtime, &opt.components, &opt.warmstart,
+        &opt.cutoff, &opt.correction, &seed
     )) {
         PyErr_SetString(SBNWError, "Invalid argument(s)");
         return NULL;
@@ -1573,13 +1580,83 @@ static PyObject* gfp_NetworkAutolayout(gfp_Network *self, PyObject *args, PyObje
         opt.baryx = gfp_UnpackPyPoint(bary).x;
         opt.baryy = gfp_UnpackPyPoint(bary).y;
     }
+    opt.random_seed = seed;
     
     if(canvas)
         c = &canvas->c;
     
-    gf_doLayoutAlgorithm2(opt, &self->n, c);
-    
-    Py_RETURN_NONE;
+    return PyLong_FromUnsignedLongLong(gf_doLayoutAlgorithm2(opt, &self->n, c));
+}
+
+static PyObject* gfp_NetworkRelayout(gfp_Network *self, PyObject *args, PyObject *kwds) {
+    fr_options opt;
+    PyObject* nodes=NULL;
+    PyObject* rxns=NULL;
+    PyObject* seq=NULL;
+    gf_node** n=NULL;
+    gf_reaction** r=NULL;
+    Py_ssize_t nn=0, nr=0, i;
+    int hops=2;
+    uint64_t iters;
+    static char *kwlist[] = {"nodes", "reactions", "hops", "k", "repulsion", "theta", "parallel", "threads", "maxiter", NULL};
+    // set defaults
+    gf_getLayoutOptDefaults(&opt);
+
+    // parse args
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "|OOi" GF_PYREALFMT "i" GF_PYREALFMT "iii", kwlist,
+        &nodes, &rxns, &hops, &opt.k, &opt.repulsion, &opt.theta, &opt.parallel, &opt.threads, &opt.maxiter
+    )) {
+        PyErr_SetString(SBNWError, "Invalid argument(s)");
+        return NULL;
+    }
+
+    if(nodes) {
+        seq = PySequence_Fast(nodes, "Expected a sequence of nodes");
+        if(!seq)
+            return NULL;
+        nn = PySequence_Fast_GET_SIZE(seq);
+        n = (gf_node**)malloc((nn+1)*sizeof(gf_node*));
+        for(i=0; i<nn; ++i) {
+            PyObject* o = PySequence_Fast_GET_ITEM(seq, i);
+            if(!PyObject_TypeCheck(o, &gfp_NodeType)) {
+                PyErr_SetString(SBNWError, "Expected a sequence of nodes");
+                free(n);
+                Py_DECREF(seq);
+                return NULL;
+            }
+            n[i] = &((gfp_Node*)o)->n;
+        }
+        Py_DECREF(seq);
+    }
+
+    if(rxns) {
+        seq = PySequence_Fast(rxns, "Expected a sequence of reactions");
+        if(!seq) {
+            free(n);
+            return NULL;
+        }
+        nr = PySequence_Fast_GET_SIZE(seq);
+        r = (gf_reaction**)malloc((nr+1)*sizeof(gf_reaction*));
+        for(i=0; i<nr; ++i) {
+            PyObject* o = PySequence_Fast_GET_ITEM(seq, i);
+            if(!PyObject_TypeCheck(o, &gfp_RxnType)) {
+                PyErr_SetString(SBNWError, "Expected a sequence of reactions");
+                free(n);
+                free(r);
+                Py_DECREF(seq);
+                return NULL;
+            }
+            r[i] = &((gfp_Rxn*)o)->r;
+        }
+        Py_DECREF(seq);
+    }
+
+    iters = gf_doIncrementalLayout(opt, &self->n, n, nn, r, nr, hops);
+
+    free(n);
+    free(r);
+
+    return PyLong_FromUnsignedLongLong(iters);
 }
 
 static PyObject* gfp_NetworkRebuildCurves(gfp_Network *self, PyObject *args, PyObject *kwds) {
@@ -1588,6 +1665,10 @@ static PyObject* gfp_NetworkRebuildCurves(gfp_Network *self, PyObject *args, PyO
     Py_RETURN_NONE;
 }
 
+static PyObject* gfp_NetworkRecalcDirtyCurves(gfp_Network *self, PyObject *args, PyObject *kwds) {
+    return PyLong_FromUnsignedLongLong(gf_nw_recalcDirtyCurves(&self->n));
+}
+
 static PyObject* gfp_NetworkRecenterJunctions(gfp_Network *self, PyObject *args, PyObject *kwds) {
     gf_nw_recenterJunctions(&self->n);
     
@@ -1988,10 +2069,42 @@ static PyMethodDef Network_methods[] = {
      ":param int autobary: Use autobary\n"
      ":param int comps: Enable compartments (leave off)\n"
      ":param int prerand: Pre-randomize\n"
+     ":param int repulsion: Repulsion method (0 = exact, 1 = Barnes-Hut, 2 = grid with cutoff)\n"
+     ":param float theta: Barnes-Hut accuracy parameter\n"
+     ":param int parallel: Compute forces on several threads\n"
+     ":param int threads: Number of threads (0 = one per core)\n"
+     ":param int multilevel: Use the multilevel scheme (large networks)\n"
+     ":param float tolerance: Stop early once converged to this tolerance (0 = off)\n"
+     ":param int adaptive: Use adaptive cooling\n"
+     ":param int maxiter: Maximum number of iterations (0 = no cap)\n"
+     ":param float maxtime: Time budget in seconds (0 = unlimited)\n"
+     ":param int components: Lay out connected components separately and pack them\n"
+     ":param int warmstart: Refine the existing layout (0 = off, 1 = if the model has one, 2 = always)\n"
+     ":param float cutoff: Range of the grid repulsion (0 = 4*k)\n"
+     ":param int correction: Iterations between full repulsion passes for the grid repulsion (0 = 10, negative = never)\n"
+     ":param int seed: Seed for a reproducible layout (0 = use rand())\n"
+     ":returns: The number of iterations run\n"
+    },
+    {"relayout", (PyCFunction)gfp_NetworkRelayout, METH_VARARGS | METH_KEYWORDS,
+     "Re-run the FR algorithm around edited nodes & reactions only (everything further away stays put)\n\n"
+     ":param nodes: The nodes that were changed\n"
+     ":param reactions: The reactions that were changed\n"
+     ":param int hops: How many species/reaction steps away from the changed elements may move\n"
+     ":param float k: The stiffness\n"
+     ":param int repulsion: Repulsion method (0 = exact, 1 = Barnes-Hut, 2 = grid with cutoff)\n"
+     ":param float theta: Barnes-Hut accuracy parameter\n"
+     ":param int parallel: Compute forces on several threads\n"
+     ":param int threads: Number of threads (0 = one per core)\n"
+     ":param int maxiter: Maximum number of iterations (0 = 50)\n"
+     ":returns: The number of iterations run\n"
     },
     {"rebuildcurves", (PyCFunction)gfp_NetworkRebuildCurves, METH_NOARGS,
      "Rebuild the curves for changed node positions"
     },
+    {"recalcdirtycurves", (PyCFunction)gfp_NetworkRecalcDirtyCurves, METH_NOARGS,
+     "Update only the curves of reactions whose nodes moved since the last update\n\n"
+     ":returns: The number of reactions updated\n"
+    },
     {"recenterjunct", (PyCFunction)gfp_NetworkRecenterJunctions, METH_NOARGS,
      "Recenter reaction junctions for changed node positions (you do not have to also call rebuildcurves)"
     },
@@ -2193,9 +2306,6 @@ static int gfp_Cubicintersec_init(gfp_Cubicintersec *self, PyObject *args, PyObj
 
 PyObject* gfp_Cubicintersec_GetPoints(gfp_Cubicintersec *self, PyObject *args, PyObject *kwds) {
     static char *kwlist[] = {"p0", "p1", "p2", "p3", "l0", "l1", NULL};
-    #if SAGITTARIUS_DEBUG_LEVEL >= 2
-    fprintf(stderr, "gfp_Cubicintersec_GetPoints called\n");
-    #endif
 
     gfp_Point* p0 = NULL;
     gfp_Point* p1 = NULL;
@@ -2252,6 +2362,8 @@ PyObject* gfp_Cubicintersec_GetPoints(gfp_Cubicintersec *self, PyObject *args, P
         ));
     }
 
+    gf_free(pts);
+
     return result;
 }
 
@@ -2714,6 +2826,28 @@ PyObject* gfp_SBMLModel_getsbml(gfp_SBMLModel *self, PyObject *args, PyObject *k
     }
 }
 
+PyObject* gfp_SBMLModel_savePatch(gfp_SBMLModel *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"filepath", NULL};
+    const char* outfile = NULL;
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "s", kwlist, &outfile)) {
+        PyErr_SetString(SBNWError, "Invalid arguments to sbnw.model.savepatch; expected filepath string");
+        return NULL;
+    }
+
+    if(!self->layout) {
+        PyErr_Format(SBNWError, "Cannot save layout patch - no layout information");
+        return NULL;
+    }
+
+    if(gf_writeSBMLLayoutPatch(outfile, self->m, self->layout->l)) {
+        PyErr_Format(SBNWError, "Unable to write file; write access may be disabled");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
 
 
 static int gfp_SBMLModel_processLayout(gfp_SBMLModel *self) {
@@ -2791,6 +2925,40 @@ PyObject* gfp_SBMLModel_renderTikZ_file(gfp_SBMLModel *self, PyObject *args, PyO
     Py_RETURN_NONE;
 }
 
+PyObject* gfp_SBMLModel_renderSVG_file(gfp_SBMLModel *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"filepath", NULL};
+    const char* outfile = NULL;
+    int error;
+
+    #if SAGITTARIUS_DEBUG_LEVEL >= 2
+//     printf("gfp_SBMLModel_renderSVG_file started\n");
+    #endif
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "s", kwlist, &outfile)) {
+        PyErr_SetString(SBNWError, "Invalid arguments to sbnw.model.savesvg; expected filepath string");
+        return NULL;
+    }
+
+    // try to add layout info if not present
+    if(!self->layout)
+        gfp_SBMLModel_processLayout(self);
+
+    if(self->layout)
+        error = gf_renderSVGFile(self->layout->l, outfile);
+    else {
+        // failed to add layout info
+        PyErr_Format(SBNWError, "No layout information");
+        return NULL;
+    }
+
+    if(error) {
+        PyErr_Format(SBNWError, "Unable to write file; write access may be disabled");
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
 static PyObject *
 gfp_SBMLModel_getLevel(gfp_SBMLModel *self, void *closure) {
     return PyLong_FromLong(self->layout->l->level);
@@ -2839,10 +3007,18 @@ static PyMethodDef gfp_SBMLModel_methods[] = {
     {"getsbml", (PyCFunction)gfp_SBMLModel_getsbml, METH_NOARGS,
      "Get the raw SBML/XML for the current model\n\n"
     },
+    {"savepatch", (PyCFunction)gfp_SBMLModel_savePatch, METH_VARARGS | METH_KEYWORDS,
+     "Save the original SBML document with only its layout updated\n\n"
+     ":param str path: The path to write the file to\n"
+    },
     {"savetikz", (PyCFunction)gfp_SBMLModel_renderTikZ_file, METH_VARARGS | METH_KEYWORDS,
      "Render the current model to TikZ\n\n"
      ":param str path: The path to write the output file to\n"
     },
+    {"savesvg", (PyCFunction)gfp_SBMLModel_renderSVG_file, METH_VARARGS | METH_KEYWORDS,
+     "Render the current model to SVG\n\n"
+     ":param str path: The path to write the output file to\n"
+    },
     {NULL}  /* Sentinel */
 };
 
@@ -44,11 +44,8 @@ void gf_freeSBMLModel(gf_SBMLModel* lo) {
     free(lo);
 }
 
-extern "C" gf_SBMLModel* gf_loadSBMLbuf(const char* buf) {
-    gf_SBMLModel* r=(gf_SBMLModel*)malloc(sizeof(gf_SBMLModel));
-    SBMLReader reader;
-    SBMLDocument* doc = reader.readSBMLFromString(buf);
-    
+// wrap a parsed document; NULL (and the document freed) if it has errors
+static gf_SBMLModel* wrapSBMLDocument(SBMLDocument* doc) {
     AN(doc, "Failed to parse SBML"); //not libSBML's documented way of failing, but just in case...
     
     if(doc->getNumErrors()) {
@@ -57,74 +54,40 @@ extern "C" gf_SBMLModel* gf_loadSBMLbuf(const char* buf) {
         for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
             std::cerr << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
         }
-        std::stringstream ss;
-        ss << "Failed to parse SBML\n";
-        for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
-            ss << "Error " << i << ": " <<doc->getError(i)->getMessage() << "\n";
-        }
-        gf_setError(ss.str().c_str());
         #endif
         // if all are warnings, continue - else abort
         for(unsigned int i=0; i<doc->getNumErrors(); ++i) {
-          if (!doc->getError(i)->isWarning())
+          if (!doc->getError(i)->isWarning()) {
+            // reported without printing, e.g. for an unreadable file
+            std::stringstream ss;
+            ss << "Failed to parse SBML\n";
+            for(unsigned int j=0; j<doc->getNumErrors(); ++j) {
+                ss << "Error " << j << ": " <<doc->getError(j)->getMessage() << "\n";
+            }
+            gf_setError(ss.str().c_str());
+            delete doc;
             return NULL;
+          }
         }
     }
     
+    gf_SBMLModel* r=(gf_SBMLModel*)malloc(sizeof(gf_SBMLModel));
     r->pdoc = doc;
     return r;
 }
 
-extern "C" gf_SBMLModel* gf_loadSBMLfile(const char* path) {
-  char* buf;
-  size_t size=0;
-  FILE* file=NULL;
-  size_t bytes_read;
-
-  try {
-
-    file = fopen(path, "rb");
-    if(!file)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to open file", "gf_loadSBMLfile");
-
-    //get t3h s!z3
-    fseek(file, 0, SEEK_END);
-    size = ftell(file);
-    rewind(file);
-    #if SAGITTARIUS_DEBUG_LEVEL >= 2
-  //     fprintf(stderr, "File size is %lu\n", size);
-    #endif
-    assert(size > 0);
-
-    //allocated buffer
-    if (sizeof(char) != 1)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "char must be one byte wide", "gf_loadSBMLfile");
-    buf=(char*)malloc(size+1); //one extra byte for null char
-    if (!buf)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to allocate buffer", "gf_loadSBMLfile");
-    //read the whole file at once
-    bytes_read = fread(buf, 1, size, file);
-    if (bytes_read != size)
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "Failed to read whole file (wrong size specified?)", "gf_loadSBMLfile");
-    //trip EOF indicator
-    fgetc(file);
-    if (!feof(file))
-      SBNW_THROW(Graphfab::InternalCheckFailureException, "EOF Expected", "gf_loadSBMLfile");
-    buf[size] = '\0'; //terminating null char
-
-    /*close*/
-    fclose(file);
-
-    gf_SBMLModel* mod = gf_loadSBMLbuf(buf);
-
-    free(buf);
-
-    return mod;
-
-  } catch (const Graphfab::Exception& e) {
-    gf_setError( e.getReport().c_str() );
-    return NULL;
-  }
+extern "C" gf_SBMLModel* gf_loadSBMLbuf(const char* buf) {
+    SBMLReader reader;
+    return wrapSBMLDocument(reader.readSBMLFromString(buf));
 }
 
-
+extern "C" gf_SBMLModel* gf_loadSBMLfile(const char* path) {
+    if(!path) {
+        gf_setError("gf_loadSBMLfile: no file");
+        return NULL;
+    }
+    // libSBML's parser reads the file in chunks, so the text is never held
+    // in memory alongside the document
+    SBMLReader reader;
+    return wrapSBMLDocument(reader.readSBMLFromFile(path));
+}
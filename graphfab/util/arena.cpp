@@ -0,0 +1,114 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/util/arena.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace Graphfab {
+
+    // alignment suitable for any object
+    union ArenaAlign {
+        long double d;
+        void* p;
+        long long l;
+    };
+
+    //--CLASS Arena--
+
+    Arena::Arena(size_t blocksize)
+        : cur_(NULL), left_(0), blocksize_(blocksize) {}
+
+    Arena::~Arena() {
+        release();
+    }
+
+    size_t Arena::roundSize(size_t size) {
+        const size_t a = sizeof(ArenaAlign);
+        if(size < sizeof(void*))
+            size = sizeof(void*);
+        return (size + a - 1)/a*a;
+    }
+
+    void* Arena::allocate(size_t size) {
+        size = roundSize(size);
+
+        // recycled slot
+        for(std::vector< std::pair<size_t, void*> >::iterator i=free_.begin(); i!=free_.end(); ++i) {
+            if(i->first == size && i->second) {
+                void* p = i->second;
+                i->second = *(void**)p;
+                return p;
+            }
+        }
+
+        if(size > left_) {
+            size_t n = size > blocksize_ ? size : blocksize_;
+            char* b = (char*)malloc(n);
+            if(!b)
+                throw std::bad_alloc();
+            blocks_.push_back(b);
+            cur_ = b;
+            left_ = n;
+        }
+        void* p = cur_;
+        cur_ += size;
+        left_ -= size;
+        return p;
+    }
+
+    void Arena::deallocate(void* p, size_t size) {
+        if(!p)
+            return;
+        size = roundSize(size);
+        for(std::vector< std::pair<size_t, void*> >::iterator i=free_.begin(); i!=free_.end(); ++i) {
+            if(i->first == size) {
+                *(void**)p = i->second;
+                i->second = p;
+                return;
+            }
+        }
+        *(void**)p = NULL;
+        free_.push_back(std::make_pair(size, p));
+    }
+
+    void Arena::release() {
+        for(std::vector<char*>::iterator i=blocks_.begin(); i!=blocks_.end(); ++i)
+            free(*i);
+        blocks_.clear();
+        free_.clear();
+        cur_ = NULL;
+        left_ = 0;
+    }
+
+}
@@ -0,0 +1,117 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file arena.h
+ * @brief Block allocator for objects with a shared lifetime
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_UTIL_ARENA_H_
+#define __SBNW_UTIL_ARENA_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+namespace Graphfab {
+
+    /** @brief Hands out memory from large blocks and frees it all at once
+     * @details Individual objects may be returned with @ref deallocate, in
+     * which case the slot is reused by the next request of the same size.
+     * Destructors are the caller's responsibility. Not thread-safe.
+     */
+    class Arena {
+        public:
+            /// Create an empty arena which grows in blocks of @a blocksize bytes
+            explicit Arena(size_t blocksize = 64*1024);
+
+            /// Frees all blocks
+            ~Arena();
+
+            /// Get @a size bytes, aligned for any object type
+            void* allocate(size_t size);
+
+            /// Return memory obtained from @ref allocate with the same @a size
+            void deallocate(void* p, size_t size);
+
+            /// Free every block; all memory handed out becomes invalid
+            void release();
+
+            /// Number of blocks currently held
+            size_t getNumBlocks() const { return blocks_.size(); }
+
+        protected:
+            // not copyable
+            Arena(const Arena&);
+            Arena& operator=(const Arena&);
+
+            /// Round up to the alignment of any object type
+            static size_t roundSize(size_t size);
+
+            /// Allocated blocks
+            std::vector<char*> blocks_;
+            /// Next free byte in the current block
+            char* cur_;
+            /// Bytes left in the current block
+            size_t left_;
+            size_t blocksize_;
+            /// Free lists (intrusive, one per size)
+            std::vector< std::pair<size_t, void*> > free_;
+    };
+
+    /** @brief Weak reference from an object to the arena that holds it
+     * @details Not carried over when the object is copied: a copy made
+     * with plain new does not live in the arena.
+     */
+    class ArenaRef {
+        public:
+            ArenaRef()
+                : arena(NULL) {}
+
+            ArenaRef(const ArenaRef&)
+                : arena(NULL) {}
+
+            ArenaRef& operator=(const ArenaRef&) { return *this; }
+
+            Arena* arena;
+    };
+
+}
+
+#endif
+
+#endif
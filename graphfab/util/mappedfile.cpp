@@ -0,0 +1,137 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/util/mappedfile.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+    #define SBNW_USE_MMAP 1
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#else
+    #define SBNW_USE_MMAP 0
+#endif
+
+namespace Graphfab {
+
+    //--CLASS MappedFile--
+
+    MappedFile::MappedFile(const char* path)
+        : data_(NULL), size_(0), maplen_(0) {
+#if SBNW_USE_MMAP
+        int fd = open(path, O_RDONLY);
+        if(fd < 0)
+            SBNW_THROW(InternalCheckFailureException, "Failed to open file", "MappedFile::MappedFile");
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            SBNW_THROW(InternalCheckFailureException, "Empty file or failed to get size", "MappedFile::MappedFile");
+        }
+        size_ = (size_t)st.st_size;
+
+        const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        void* p = MAP_FAILED;
+        if(size_ % page) {
+            // the rest of the last page is zero-filled, which terminates the string
+            maplen_ = size_;
+            p = mmap(NULL, maplen_, PROT_READ, MAP_PRIVATE, fd, 0);
+        } else {
+            // reserve one extra zero page after the file, then map the file over the front
+            maplen_ = size_ + page;
+            void* r = mmap(NULL, maplen_, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(r != MAP_FAILED) {
+                p = mmap(r, size_, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+                if(p == MAP_FAILED)
+                    munmap(r, maplen_);
+            }
+        }
+        close(fd);
+
+        if(p == MAP_FAILED) {
+            // e.g. pipes or special files
+            maplen_ = 0;
+            readWhole(path);
+            return;
+        }
+        // parsers read front to back
+        madvise(p, maplen_, MADV_SEQUENTIAL);
+        data_ = (char*)p;
+#else
+        readWhole(path);
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#if SBNW_USE_MMAP
+        if(maplen_) {
+            munmap(data_, maplen_);
+            return;
+        }
+#endif
+        free(data_);
+    }
+
+    void MappedFile::readWhole(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if(!file)
+            SBNW_THROW(InternalCheckFailureException, "Failed to open file", "MappedFile::readWhole");
+
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        rewind(file);
+        if(size <= 0) {
+            fclose(file);
+            SBNW_THROW(InternalCheckFailureException, "Empty file or failed to get size", "MappedFile::readWhole");
+        }
+        size_ = (size_t)size;
+
+        data_ = (char*)malloc(size_+1); //one extra byte for null char
+        if(!data_) {
+            fclose(file);
+            SBNW_THROW(InternalCheckFailureException, "Failed to allocate buffer", "MappedFile::readWhole");
+        }
+        size_t bytes_read = fread(data_, 1, size_, file);
+        fclose(file);
+        if(bytes_read != size_) {
+            free(data_);
+            data_ = NULL;
+            SBNW_THROW(InternalCheckFailureException, "Failed to read whole file", "MappedFile::readWhole");
+        }
+        data_[size_] = '\0';
+    }
+
+}
@@ -0,0 +1,92 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file mappedfile.h
+ * @brief Read-only, null-terminated view of a whole file
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_UTIL_MAPPEDFILE_H_
+#define __SBNW_UTIL_MAPPEDFILE_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <cstddef>
+
+namespace Graphfab {
+
+    /** @brief Maps a file into memory for reading
+     * @details The contents are always followed by a null character, so
+     * the data can be passed to parsers expecting a C string. On POSIX
+     * systems the file is memory-mapped and pages are read on demand;
+     * elsewhere it is read into a heap buffer.
+     * Throws @ref InternalCheckFailureException if the file cannot be
+     * opened, is empty, or cannot be mapped.
+     */
+    class MappedFile {
+        public:
+            explicit MappedFile(const char* path);
+
+            /// Unmaps / frees the data
+            ~MappedFile();
+
+            /// The file contents, followed by a null character
+            const char* getData() const { return data_; }
+
+            /// Size of the file in bytes (excluding the null character)
+            size_t getSize() const { return size_; }
+
+            /// True if the data is memory-mapped (rather than copied)
+            bool isMapped() const { return maplen_ != 0; }
+
+        protected:
+            // not copyable
+            MappedFile(const MappedFile&);
+            MappedFile& operator=(const MappedFile&);
+
+            /// Read the whole file into a heap buffer
+            void readWhole(const char* path);
+
+            char* data_;
+            size_t size_;
+            /// Length of the mapping, zero if the data is on the heap
+            size_t maplen_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/util/sink.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <clocale>
+
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+    #include <unistd.h>
+#else
+    #include <io.h>
+#endif
+
+namespace Graphfab {
+
+    //--CLASS OutputSink--
+
+    OutputSink::OutputSink(gf_writeCallback write, void* user, size_t bufsize)
+      : write_(write), user_(user), buf_(NULL), size_(bufsize ? bufsize : 1), used_(0), failed_(false) {
+        AN(write_, "No write callback");
+        buf_ = (char*)malloc(size_);
+        AN(buf_, "Failed to allocate output buffer");
+    }
+
+    OutputSink::~OutputSink() {
+        flush();
+        free(buf_);
+    }
+
+    int OutputSink::writeFILE(const char* data, size_t size, void* user) {
+        return fwrite(data, 1, size, (FILE*)user) == size ? 0 : -1;
+    }
+
+    int OutputSink::writeFD(const char* data, size_t size, void* user) {
+        const int fd = *(int*)user;
+        while(size) {
+#if SAGITTARIUS_PLATFORM != SAGITTARIUS_PLATFORM_WIN
+            ssize_t n = ::write(fd, data, size);
+#else
+            int n = _write(fd, data, (unsigned int)size);
+#endif
+            if(n < 0) {
+                if(errno == EINTR)
+                    continue;
+                return -1;
+            }
+            data += n;
+            size -= (size_t)n;
+        }
+        return 0;
+    }
+
+    void OutputSink::put(const char* data, size_t size) {
+        if(size >= size_) {
+            // larger than the buffer: pass it straight through
+            flushBuffer();
+            if(!failed_ && write_(data, size, user_))
+                failed_ = true;
+            return;
+        }
+        if(used_ + size > size_)
+            flushBuffer();
+        memcpy(buf_ + used_, data, size);
+        used_ += size;
+    }
+
+    void OutputSink::put(const char* s) {
+        put(s, strlen(s));
+    }
+
+    void OutputSink::putReal(Real x, int digits) {
+        char b[32];
+        int n = snprintf(b, sizeof(b), "%.*g", digits, (double)x);
+        // snprintf uses the radix of the current locale, but XML wants '.'
+        char radix = *localeconv()->decimal_point;
+        if(radix != '.') {
+            for(int i=0; i<n; ++i)
+                if(b[i] == radix)
+                    b[i] = '.';
+        }
+        put(b, (size_t)n);
+    }
+
+    void OutputSink::putInt(int64 x) {
+        char b[32];
+        int n = snprintf(b, sizeof(b), "%lld", (long long)x);
+        put(b, (size_t)n);
+    }
+
+    void OutputSink::putEscaped(const std::string& s) {
+        const char* p = s.data();
+        const char* end = p + s.size();
+        const char* run = p;
+        for(; p != end; ++p) {
+            const char* esc;
+            switch(*p) {
+                case '&':  esc = "&amp;"; break;
+                case '<':  esc = "&lt;"; break;
+                case '>':  esc = "&gt;"; break;
+                case '"':  esc = "&quot;"; break;
+                case '\'': esc = "&apos;"; break;
+                default: continue;
+            }
+            put(run, (size_t)(p - run));
+            put(esc);
+            run = p + 1;
+        }
+        put(run, (size_t)(end - run));
+    }
+
+    bool OutputSink::flush() {
+        flushBuffer();
+        return !failed_;
+    }
+
+    void OutputSink::flushBuffer() {
+        if(used_ && !failed_ && write_(buf_, used_, user_))
+            failed_ = true;
+        used_ = 0;
+    }
+
+}
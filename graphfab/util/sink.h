@@ -0,0 +1,136 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file sink.h
+ * @brief Buffered output to a file or callback
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_UTIL_SINK_H_
+#define __SBNW_UTIL_SINK_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+//-- C code --
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  @brief Receives output from the streaming writers
+ *  @details Called with consecutive chunks of the output. The chunks
+ *  are not null-terminated.
+ *  @param[in] user The pointer passed to the writer
+ *  @return 0 to continue; anything else stops the writer, which then
+ *  reports failure
+ *  \ingroup C_API
+ */
+typedef int (*gf_writeCallback)(const char* data, size_t size, void* user);
+
+#ifdef __cplusplus
+}
+#endif
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <string>
+
+namespace Graphfab {
+
+    /** @brief Fixed-size buffer in front of a @ref gf_writeCallback
+     * @details Memory use is bounded by the buffer size however much
+     * is written. Once the callback fails, further output is
+     * discarded and @ref failed returns true.
+     */
+    class OutputSink {
+        public:
+            OutputSink(gf_writeCallback write, void* user, size_t bufsize = 65536);
+
+            /// Flushes the remaining output
+            ~OutputSink();
+
+            /// Callback which writes to the @c FILE* passed as @a user
+            static int writeFILE(const char* data, size_t size, void* user);
+
+            /// Callback which writes to the file descriptor pointed to by @a user (an @c int*)
+            static int writeFD(const char* data, size_t size, void* user);
+
+            void put(const char* data, size_t size);
+
+            void put(const char* s);
+
+            void put(const std::string& s) { put(s.data(), s.size()); }
+
+            void put(char c) {
+                if(used_ == size_)
+                    flushBuffer();
+                buf_[used_++] = c;
+            }
+
+            /// Write with @c %.15g (enough to round-trip most coordinates) and a '.' radix in any locale
+            void putReal(Real x, int digits = 15);
+
+            void putInt(int64 x);
+
+            /// Write @a s with the XML special characters escaped
+            void putEscaped(const std::string& s);
+
+            /// Pass the buffered output to the callback; false if the sink has failed
+            bool flush();
+
+            bool failed() const { return failed_; }
+
+        protected:
+            // not copyable
+            OutputSink(const OutputSink&);
+            OutputSink& operator=(const OutputSink&);
+
+            void flushBuffer();
+
+            gf_writeCallback write_;
+            void* user_;
+            char* buf_;
+            size_t size_;
+            size_t used_;
+            bool failed_;
+    };
+
+}
+
+#endif
+
+#endif
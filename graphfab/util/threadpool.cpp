@@ -0,0 +1,138 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/util/threadpool.h"
+
+namespace Graphfab {
+
+    //--CLASS ThreadPool--
+
+    ThreadPool::ThreadPool(uint64 nthreads)
+        : task_(NULL), n_(0), grain_(1), next_(0), busy_(0), generation_(0), quit_(false) {
+        if(!nthreads)
+            nthreads = getHardwareConcurrency();
+        for(uint64 i=1; i<nthreads; ++i)
+            workers_.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for(std::vector<std::thread>::iterator i=workers_.begin(); i!=workers_.end(); ++i)
+            i->join();
+    }
+
+    uint64 ThreadPool::getHardwareConcurrency() {
+        uint64 n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    void ThreadPool::drain() {
+        for(;;) {
+            uint64 begin = next_.fetch_add(grain_);
+            if(begin >= n_)
+                return;
+            uint64 end = begin + grain_ < n_ ? begin + grain_ : n_;
+            try {
+                task_->run(begin, end);
+            } catch(...) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if(!error_)
+                    error_ = std::current_exception();
+            }
+        }
+    }
+
+    void ThreadPool::workerLoop() {
+        uint64 seen = 0;
+        for(;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while(!quit_ && generation_ == seen)
+                    wake_.wait(lock);
+                if(quit_)
+                    return;
+                seen = generation_;
+            }
+
+            drain();
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if(--busy_ == 0)
+                    done_.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::parallelFor(uint64 n, uint64 grain, RangeTask& task) {
+        if(!n)
+            return;
+        if(!grain)
+            grain = 1;
+
+        if(workers_.empty() || n <= grain) {
+            task.run(0, n);
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_ = &task;
+            n_ = n;
+            grain_ = grain;
+            next_ = 0;
+            busy_ = workers_.size();
+            error_ = std::exception_ptr();
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        drain();
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while(busy_)
+                done_.wait(lock);
+            task_ = NULL;
+            error = error_;
+        }
+
+        if(error)
+            std::rethrow_exception(error);
+    }
+
+}
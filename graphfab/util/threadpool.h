@@ -0,0 +1,119 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== FILEDOC =========================================================================
+
+/** @file threadpool.h
+ * @brief Fixed-size pool of worker threads
+  */
+
+//== BEGINNING OF CODE ===============================================================
+
+#ifndef __SBNW_UTIL_THREADPOOL_H_
+#define __SBNW_UTIL_THREADPOOL_H_
+
+//== INCLUDES ========================================================================
+
+#include "graphfab/core/SagittariusCore.h"
+
+//-- C++ code --
+#ifdef __cplusplus
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace Graphfab {
+
+    /** @brief Work item for @ref ThreadPool::parallelFor
+     * @details Implementations must only write to state owned by the
+     * indices in the range they are given.
+     */
+    class RangeTask {
+        public:
+            virtual ~RangeTask() {}
+
+            /// Process the indices in [begin, end)
+            virtual void run(uint64 begin, uint64 end) = 0;
+    };
+
+    /** @brief A fixed set of worker threads
+     * @details The calling thread also takes part in the work, so a pool
+     * with one thread does everything on the caller.
+     */
+    class ThreadPool {
+        public:
+            /// Create a pool with @a nthreads threads (0 = number of cores)
+            explicit ThreadPool(uint64 nthreads = 0);
+
+            ~ThreadPool();
+
+            /// Number of threads (including the caller)
+            uint64 getNumThreads() const { return workers_.size()+1; }
+
+            /** @brief Run @a task over [0, n) in chunks of @a grain indices
+             * @details Chunk boundaries depend only on @a n and @a grain, never
+             * on the number of threads. Blocks until all chunks are done.
+             * An exception thrown by the task is rethrown here.
+             */
+            void parallelFor(uint64 n, uint64 grain, RangeTask& task);
+
+            /// Number of cores reported by the system (at least 1)
+            static uint64 getHardwareConcurrency();
+
+        protected:
+            /// Worker thread main loop
+            void workerLoop();
+
+            /// Take chunks of the current job until none are left
+            void drain();
+
+            std::vector<std::thread> workers_;
+
+            std::mutex mutex_;
+            std::condition_variable wake_;
+            std::condition_variable done_;
+
+            // current job
+            RangeTask* task_;
+            uint64 n_;
+            uint64 grain_;
+            std::atomic<uint64> next_;
+            uint64 busy_;
+            uint64 generation_;
+            bool quit_;
+            std::exception_ptr error_;
+    };
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+/* Lay out a list of SBML files on several threads.
+ *
+ * usage: batch-layout [-j threads] [-m max_inflight_MB] [-o outdir] [-l listfile] [-c cachedir] files...
+ *
+ * Each output is written to outdir/<file name> if -o is given, otherwise
+ * next to the input as <input>.layout.xml. A list file holds one path
+ * per line. With -c, finished layouts are cached in cachedir and reused
+ * for models with the same structure.
+ */
+
+#include "graphfab/core/SagittariusCore.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graphfab/interface/batch.h"
+#include "graphfab/layout/layoutcache.h"
+
+typedef struct {
+    char** v;
+    size_t n, size;
+} strlist;
+
+static void strlist_push(strlist* l, const char* s) {
+    if(l->n == l->size) {
+        l->size = l->size ? l->size*2 : 64;
+        l->v = (char**)realloc(l->v, l->size*sizeof(char*));
+    }
+    l->v[l->n] = (char*)malloc(strlen(s)+1);
+    strcpy(l->v[l->n], s);
+    ++l->n;
+}
+
+static void strlist_free(strlist* l) {
+    size_t i;
+    for(i=0; i<l->n; ++i)
+        free(l->v[i]);
+    free(l->v);
+}
+
+static int read_list(strlist* l, const char* path) {
+    char line[4096];
+    FILE* f = fopen(path, "r");
+    if(!f)
+        return -1;
+    while(fgets(line, sizeof(line), f)) {
+        size_t k = strlen(line);
+        while(k && (line[k-1] == '\n' || line[k-1] == '\r'))
+            line[--k] = '\0';
+        if(k)
+            strlist_push(l, line);
+    }
+    fclose(f);
+    return 0;
+}
+
+static const char* base_name(const char* path) {
+    const char* b = path;
+    const char* p;
+    for(p=path; *p; ++p)
+        if(*p == '/' || *p == '\\')
+            b = p+1;
+    return b;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: batch-layout [-j threads] [-m max_inflight_MB] [-o outdir] [-l listfile] [-c cachedir] files...\n");
+}
+
+int main(int argc, char* argv[]) {
+    strlist inputs = {NULL, 0, 0};
+    strlist outputs = {NULL, 0, 0};
+    const char* outdir = NULL;
+    const char* cachedir = NULL;
+    gf_batchOptions bopt;
+    fr_options opt;
+    gf_batchResult* results;
+    gf_batchStats stats;
+    uint64_t failed;
+    size_t i;
+    int s;
+
+    gf_getBatchOptDefaults(&bopt);
+    gf_getLayoutOptDefaults(&opt);
+
+    for(s=1; s<argc; ++s) {
+        if(!strcmp(argv[s], "-j") || !strcmp(argv[s], "-m") || !strcmp(argv[s], "-o") || !strcmp(argv[s], "-l") || !strcmp(argv[s], "-c")) {
+            if(s+1 >= argc) {
+                usage();
+                return -1;
+            }
+            if(!strcmp(argv[s], "-j"))
+                bopt.threads = strtoull(argv[s+1], NULL, 10);
+            else if(!strcmp(argv[s], "-m"))
+                bopt.max_inflight_bytes = strtoull(argv[s+1], NULL, 10)*1024*1024;
+            else if(!strcmp(argv[s], "-o"))
+                outdir = argv[s+1];
+            else if(!strcmp(argv[s], "-c"))
+                cachedir = argv[s+1];
+            else if(read_list(&inputs, argv[s+1])) {
+                fprintf(stderr, "Failed to read list %s\n", argv[s+1]);
+                return -1;
+            }
+            ++s;
+        } else
+            strlist_push(&inputs, argv[s]);
+    }
+
+    if(!inputs.n) {
+        usage();
+        return -1;
+    }
+
+    for(i=0; i<inputs.n; ++i) {
+        const char* in = inputs.v[i];
+        char* out;
+        if(outdir) {
+            out = (char*)malloc(strlen(outdir) + strlen(base_name(in)) + 2);
+            sprintf(out, "%s/%s", outdir, base_name(in));
+        } else {
+            out = (char*)malloc(strlen(in) + strlen(".layout.xml") + 1);
+            sprintf(out, "%s.layout.xml", in);
+        }
+        strlist_push(&outputs, out);
+        free(out);
+    }
+
+    if(cachedir && gf_enableLayoutCache(cachedir, NULL)) {
+        fprintf(stderr, "Failed to open layout cache %s: %s\n", cachedir, gf_getLastError());
+        return -1;
+    }
+
+    results = (gf_batchResult*)malloc(inputs.n*sizeof(gf_batchResult));
+    failed = gf_batchLayout((const char* const*)inputs.v, (const char* const*)outputs.v, inputs.n,
+                            opt, bopt, results, &stats);
+
+    for(i=0; i<inputs.n; ++i)
+        if(results[i].status)
+            fprintf(stderr, "FAILED %s (%s): %s\n", inputs.v[i],
+                    gf_batchStageName(results[i].failed_stage), results[i].error);
+
+    printf("files: %lu ok, %lu failed, %lu threads\n",
+           (unsigned long)(stats.files - stats.failed), (unsigned long)stats.failed, (unsigned long)stats.threads);
+    printf("wall time: %.3f s, %.2f files/s, %.2f MB/s\n", stats.wall_time,
+           stats.wall_time > 0 ? stats.files/stats.wall_time : 0.,
+           stats.wall_time > 0 ? stats.bytes/(1024.*1024.)/stats.wall_time : 0.);
+    printf("%-8s %12s %12s %7s\n", "stage", "total (s)", "mean (ms)", "share");
+    {
+        double total = 0.;
+        for(s=0; s<GF_BATCH_NUM_STAGES; ++s)
+            total += stats.stage_time[s];
+        for(s=0; s<GF_BATCH_NUM_STAGES; ++s)
+            printf("%-8s %12.3f %12.3f %6.1f%%\n", gf_batchStageName((gf_batchStage)s), stats.stage_time[s],
+                   stats.files ? 1000.*stats.stage_time[s]/stats.files : 0.,
+                   total > 0 ? 100.*stats.stage_time[s]/total : 0.);
+    }
+    if(cachedir) {
+        gf_layoutCacheStats cstats;
+        gf_getLayoutCacheStats(&cstats);
+        printf("layout cache: %lu hits, %lu misses, %lu entries, %.2f MB\n",
+               (unsigned long)cstats.hits, (unsigned long)cstats.misses,
+               (unsigned long)cstats.entries, cstats.bytes/(1024.*1024.));
+        gf_disableLayoutCache();
+    }
+
+    free(results);
+    strlist_free(&inputs);
+    strlist_free(&outputs);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,154 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+// Checks the closed-form box clipping of curves against the bisection
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/layout/curve.h"
+#include "gtest/gtest.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+using namespace Graphfab;
+
+class TestCurve : public RxnBezier {
+public:
+    TestCurve(const Point& s_, const Point& c1_, const Point& c2_, const Point& e_) {
+        s = s_;
+        c1 = c1_;
+        c2 = c2_;
+        e = e_;
+    }
+
+    RxnCurveType getRole() const { return RXN_CURVE_SUBSTRATE; }
+
+    Point getCentroidCP() const { return c1; }
+
+    bool isStartNodeSide() const { return false; }
+
+    ArrowheadStyle getArrowheadStyle() const { return 0; }
+};
+
+static Real urand(Real lo, Real hi) {
+    return lo + (hi - lo)*rand()/(Real)RAND_MAX;
+}
+
+static Point prand(Real lo, Real hi) {
+    return Point(urand(lo, hi), urand(lo, hi));
+}
+
+static const Real cutoff = 0.1;
+
+// crossings of the half of the curve that is clipped
+static int numCrossings(const TestCurve& c, const Box& b, bool forward) {
+    CubicBezierBoxIntersection x(CubicBezier2Desc(c.s, c.c1, c.c2, c.e), b, forward ? 0.5 : 0., forward ? 1. : 0.5);
+    return x.getNumIntersections();
+}
+
+// distance from @a p to the nearest edge of @a b
+static Real borderDist(const Point& p, const Box& b) {
+    Real dx = max(max(b.getMin().x - p.x, p.x - b.getMax().x), 0.);
+    Real dy = max(max(b.getMin().y - p.y, p.y - b.getMax().y), 0.);
+    if(dx > 0. || dy > 0.)
+        return sqrt(dx*dx + dy*dy);
+    return min(min(p.x - b.getMin().x, b.getMax().x - p.x), min(p.y - b.getMin().y, b.getMax().y - p.y));
+}
+
+// cases where only the exact clip reached the box
+static int nearMisses = 0;
+
+// clip both ways and compare the clipped end points; the control points
+// move with the curve's speed at the split and are not compared
+
+static void checkClip(const TestCurve& c, const Box& b, bool forward) {
+    TestCurve exact(c), bisect(c);
+    Point pe, pb;
+    if(forward) {
+        exact.clipForwardToBox(b, cutoff);
+        bisect.clipForwardToBoxBisect(b, cutoff);
+        pe = exact.e;
+        pb = bisect.e;
+    } else {
+        exact.clipReverseToBox(b, cutoff);
+        bisect.clipReverseToBoxBisect(b, cutoff);
+        pe = exact.s;
+        pb = bisect.s;
+    }
+    // the bisection stops early if the curve comes back close to the
+    // point sampled last, short of the box; the exact crossing is kept then
+    if(borderDist(pb, b) > cutoff && borderDist(pe, b) <= cutoff) {
+        ++nearMisses;
+        return;
+    }
+    // both stop within about one step of the crossing
+    EXPECT_LE((pe - pb).mag(), 2.*cutoff) << "curve " << c << " box " << b;
+}
+
+// a node box around the end (@a forward) or start of the curve
+static Box nodeBox(const TestCurve& c, bool forward) {
+    Point p = forward ? c.e : c.s;
+    Point half(urand(10., 40.), urand(5., 20.));
+    return Box(p - half, p + half);
+}
+
+TEST(CurveClip, RandomCurves) {
+    srand(1);
+    nearMisses = 0;
+    for(int i=0; i<20000; ++i) {
+        TestCurve c(prand(0., 1000.), prand(0., 1000.), prand(0., 1000.), prand(0., 1000.));
+        bool forward = i % 2;
+        Box b = nodeBox(c, forward);
+        checkClip(c, b, forward);
+    }
+    EXPECT_LT(nearMisses, 200);
+}
+
+TEST(CurveClip, MultipleCrossings) {
+    // curves which leave the node box and come back: the control points
+    // near the node pull the curve through the box more than once
+    srand(2);
+    int tested = 0;
+    nearMisses = 0;
+    for(int i=0; i<400000 && tested < 10000; ++i) {
+        bool forward = i % 2;
+        Point p = prand(0., 1000.);
+        TestCurve c(prand(0., 1000.), p + prand(-60., 60.), p + prand(-60., 60.), p);
+        if(!forward)
+            c = TestCurve(p, p + prand(-60., 60.), p + prand(-60., 60.), prand(0., 1000.));
+        Box b = nodeBox(c, forward);
+        if(numCrossings(c, b, forward) < 2)
+            continue;
+        ++tested;
+        checkClip(c, b, forward);
+    }
+    EXPECT_GT(tested, 1000);
+    // the skipped cases must stay rare
+    EXPECT_LT(nearMisses, tested/100) << nearMisses << " of " << tested;
+}
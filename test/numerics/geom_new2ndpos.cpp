@@ -0,0 +1,141 @@
+/*== SAGITTARIUS =====================================================================
+ * Copyright (c) 2012, Jesse K Medley
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+    * Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+    * Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+    * Neither the name of The University of Washington nor the
+      names of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written permission.
+
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL 
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+//== BEGINNING OF CODE ===============================================================
+
+// Checks the vector form of new2ndPos against the original trig formula
+
+#include "graphfab/core/SagittariusCore.h"
+#include "graphfab/math/geom.h"
+#include "gtest/gtest.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+using namespace Graphfab;
+
+// the implementation before it was rewritten without trig
+static Point new2ndPosTrig(const Point& first, const Point& second, const Real deg, const Real dist, const bool rel_dist) {
+    Real h, o, a, x;
+    Real hnew, onew, anew;
+
+    o = second.y - first.y;
+    a = second.x - first.x;
+    h = sqrt(pow(a,2.) + pow(o,2.));
+
+    if(rel_dist)
+        hnew = h + h*dist;
+    else
+        hnew = h + dist;
+
+    const Real ep = 1e-6;
+
+    if(mag(a) > ep)
+        x = atan(o/a);
+    else
+        x = sign(o)*3.14159/2.;
+
+    onew = hnew * sin(x + deg2r(deg));
+    anew = hnew * cos(x + deg2r(deg));
+
+    if(second.x >= first.x)
+        return Point(first.x + anew, first.y + onew);
+    else
+        return Point(first.x - anew, first.y - onew);
+}
+
+static Real urand(Real lo, Real hi) {
+    return lo + (hi - lo)*rand()/(Real)RAND_MAX;
+}
+
+// distance between the two results relative to the length of the new vector
+static Real relDiff(const Point& first, const Point& second, Real deg, Real dist, bool rel_dist) {
+    Point p = new2ndPos(first, second, deg, dist, rel_dist);
+    Point q = new2ndPosTrig(first, second, deg, dist, rel_dist);
+    Real len = (q - first).mag();
+    return (p - q).mag()/(len > 1. ? len : 1.);
+}
+
+// the vertical convention uses pi = 3.14159, hence the tolerance
+static const Real tol = 1e-5;
+
+TEST(New2ndPos, RandomPairs) {
+    srand(1);
+    Real worst = 0.;
+    for(int i=0; i<200000; ++i) {
+        Point first(urand(-1000., 1000.), urand(-1000., 1000.));
+        Point second(urand(-1000., 1000.), urand(-1000., 1000.));
+        Real deg = (i % 4 == 0) ? 0. : urand(-180., 180.);
+        bool rel = i % 2;
+        Real dist = rel ? urand(-0.9, 2.) : urand(-50., 50.);
+        Real d = relDiff(first, second, deg, dist, rel);
+        if(d > worst)
+            worst = d;
+    }
+    EXPECT_LT(worst, tol);
+}
+
+TEST(New2ndPos, VerticalAndNearVertical) {
+    const Real offsets[] = {0., 1e-9, -1e-9, 5e-7, -5e-7, 2e-6, -2e-6};
+    const Real ys[] = {10., -10., 1e-3, -250.};
+    const Real degs[] = {0., 30., -90., 180.};
+    for(size_t i=0; i<sizeof(offsets)/sizeof(offsets[0]); ++i)
+        for(size_t j=0; j<sizeof(ys)/sizeof(ys[0]); ++j)
+            for(size_t k=0; k<sizeof(degs)/sizeof(degs[0]); ++k) {
+                Point first(3., 4.);
+                Point second(3. + offsets[i], 4. + ys[j]);
+                EXPECT_LT(relDiff(first, second, degs[k], 20., false), tol) << "dx=" << offsets[i] << " dy=" << ys[j] << " deg=" << degs[k];
+                EXPECT_LT(relDiff(first, second, degs[k], 0.5, true), tol) << "dx=" << offsets[i] << " dy=" << ys[j] << " deg=" << degs[k];
+            }
+}
+
+TEST(New2ndPos, Coincident) {
+    const Real degs[] = {0., 45., -120.};
+    for(size_t k=0; k<sizeof(degs)/sizeof(degs[0]); ++k) {
+        Point p(-7., 12.);
+        EXPECT_LT(relDiff(p, p, degs[k], 20., false), tol);
+        EXPECT_LT(relDiff(p, p, degs[k], -20., false), tol);
+        // relative extension of a zero vector stays put
+        EXPECT_LT(relDiff(p, p, degs[k], 0.5, true), tol);
+    }
+}
+
+TEST(New2ndPos, Batched) {
+    srand(2);
+    std::vector<Point> first, second, result(1000);
+    for(int i=0; i<1000; ++i) {
+        first.push_back(Point(urand(-100., 100.), urand(-100., 100.)));
+        second.push_back(i % 10 ? Point(urand(-100., 100.), urand(-100., 100.)) : Point(first.back().x, first.back().y + 5.));
+    }
+    new2ndPos(&first[0], &second[0], first.size(), 25., -10., false, &result[0]);
+    for(size_t i=0; i<first.size(); ++i) {
+        Point p = new2ndPos(first[i], second[i], 25., -10., false);
+        EXPECT_EQ(p.x, result[i].x);
+        EXPECT_EQ(p.y, result[i].y);
+    }
+}